@@ -0,0 +1,303 @@
+#include "GCUtil.h"
+#include "AllocationProfiler.h"
+
+#ifdef GCUTIL_ALLOC_PROFILER
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#if defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <unwind.h>
+#endif
+
+namespace GCUtil {
+
+MAY_THREAD_LOCAL intptr_t g_bytesUntilNextSample = INTPTR_MAX;
+
+struct StackTrace {
+    void* frames[AllocationProfiler::maxStackDepth];
+    int depth;
+};
+
+// Samples aggregated by their call stack.
+struct StackRecord {
+    StackTrace stack;
+    size_t allocCount;
+    size_t allocBytes;
+    size_t inuseCount;
+    size_t inuseBytes;
+};
+
+struct Sample {
+    uintptr_t base;
+    size_t size;
+    size_t record;
+};
+
+struct ProfilerState {
+    bool running;
+    size_t samplingInterval;
+    uint64_t randomState;
+    std::vector<StackRecord> records;
+    std::unordered_multimap<size_t, size_t> recordIndex; // stack hash -> records
+    std::unordered_map<uintptr_t, Sample> liveSamples; // keyed by user pointer
+};
+
+static MAY_THREAD_LOCAL ProfilerState* s_profiler = nullptr;
+static MAY_THREAD_LOCAL bool s_beforeSweepInstalled = false;
+static MAY_THREAD_LOCAL GC_before_sweep_proc s_prevBeforeSweep = nullptr;
+
+// Distance to the next sample drawn from an exponential distribution
+// whose mean is the sampling interval.
+static intptr_t nextSampleDistance(ProfilerState& state)
+{
+    // xorshift64*
+    uint64_t x = state.randomState;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    state.randomState = x;
+    x *= 0x2545F4914F6CDD1DULL;
+
+    // Uniform value in (0, 1].
+    double u = ((x >> 11) + 1) * (1.0 / 9007199254740992.0);
+    double distance = -std::log(u) * (double)state.samplingInterval;
+    if (distance < 1) {
+        return 1;
+    }
+    if (distance > (double)(INTPTR_MAX / 2)) {
+        return INTPTR_MAX / 2;
+    }
+    return (intptr_t)distance;
+}
+
+#if !defined(_MSC_VER)
+struct UnwindState {
+    StackTrace* stack;
+    int skip;
+};
+
+static _Unwind_Reason_Code unwindCallback(struct _Unwind_Context* context, void* arg)
+{
+    UnwindState* state = (UnwindState*)arg;
+    uintptr_t pc = _Unwind_GetIP(context);
+    if (!pc) {
+        return _URC_END_OF_STACK;
+    }
+    if (state->skip > 0) {
+        state->skip--;
+        return _URC_NO_REASON;
+    }
+    state->stack->frames[state->stack->depth++] = (void*)pc;
+    return state->stack->depth < AllocationProfiler::maxStackDepth ? _URC_NO_REASON : _URC_END_OF_STACK;
+}
+#endif
+
+// Must not be inlined, otherwise its own frame is not there to skip.
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+static void captureStackTrace(StackTrace& stack, int skip)
+{
+    stack.depth = 0;
+#if defined(_MSC_VER)
+    stack.depth = CaptureStackBackTrace(skip + 1, AllocationProfiler::maxStackDepth, stack.frames, nullptr);
+#else
+    UnwindState state = { &stack, skip + 1 };
+    _Unwind_Backtrace(unwindCallback, &state);
+#endif
+}
+
+static size_t stackHash(const StackTrace& stack)
+{
+    size_t hash = (size_t)stack.depth;
+    for (int i = 0; i < stack.depth; i++) {
+        hash = hash * 31 + (size_t)stack.frames[i];
+    }
+    return hash;
+}
+
+static size_t findOrCreateRecord(ProfilerState& state, const StackTrace& stack)
+{
+    size_t hash = stackHash(stack);
+    auto range = state.recordIndex.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const StackTrace& other = state.records[it->second].stack;
+        if (other.depth == stack.depth
+            && !memcmp(other.frames, stack.frames, stack.depth * sizeof(void*))) {
+            return it->second;
+        }
+    }
+
+    size_t index = state.records.size();
+    state.records.push_back(StackRecord{ stack, 0, 0, 0, 0 });
+    state.recordIndex.insert(std::make_pair(hash, index));
+    return index;
+}
+
+static void releaseSample(ProfilerState& state, const Sample& sample)
+{
+    StackRecord& record = state.records[sample.record];
+    record.inuseCount--;
+    record.inuseBytes -= sample.size;
+}
+
+// Called by the collector after marking. Samples which are still
+// unmarked are reclaimed by the upcoming sweep.
+static void GC_CALLBACK releaseUnmarkedSamples()
+{
+    if (s_profiler) {
+        auto& samples = s_profiler->liveSamples;
+        for (auto it = samples.begin(); it != samples.end();) {
+            if (!GC_is_marked((void*)it->second.base)) {
+                releaseSample(*s_profiler, it->second);
+                it = samples.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    if (s_prevBeforeSweep) {
+        s_prevBeforeSweep();
+    }
+}
+
+void sampleAllocation(void* ptr, size_t siz)
+{
+    if (!s_profiler || !s_profiler->running) {
+        g_bytesUntilNextSample = INTPTR_MAX;
+        return;
+    }
+
+    ProfilerState& state = *s_profiler;
+    g_bytesUntilNextSample = nextSampleDistance(state);
+
+    StackTrace stack;
+    captureStackTrace(stack, 1);
+    size_t index = findOrCreateRecord(state, stack);
+
+    StackRecord& record = state.records[index];
+    record.allocCount++;
+    record.allocBytes += siz;
+    record.inuseCount++;
+    record.inuseBytes += siz;
+
+    auto it = state.liveSamples.find((uintptr_t)ptr);
+    if (it != state.liveSamples.end()) {
+        // The previous object at this address died unnoticed.
+        releaseSample(state, it->second);
+        state.liveSamples.erase(it);
+    }
+#if defined(GC_DEBUG)
+    uintptr_t base = (uintptr_t)GC_base(ptr);
+#else
+    uintptr_t base = (uintptr_t)ptr;
+#endif
+    state.liveSamples[(uintptr_t)ptr] = Sample{ base, siz, index };
+}
+
+void forgetSampledAllocation(void* ptr)
+{
+    if (!s_profiler || s_profiler->liveSamples.empty()) {
+        return;
+    }
+
+    auto it = s_profiler->liveSamples.find((uintptr_t)ptr);
+    if (it != s_profiler->liveSamples.end()) {
+        releaseSample(*s_profiler, it->second);
+        s_profiler->liveSamples.erase(it);
+    }
+}
+
+void AllocationProfiler::start(size_t samplingInterval)
+{
+    RELEASE_ASSERT(samplingInterval > 0);
+
+    delete s_profiler;
+    s_profiler = new ProfilerState();
+    s_profiler->running = true;
+    s_profiler->samplingInterval = samplingInterval;
+    s_profiler->randomState = ((uint64_t)(uintptr_t)&samplingInterval << 16) ^ 0x9E3779B97F4A7C15ULL;
+    g_bytesUntilNextSample = nextSampleDistance(*s_profiler);
+
+    if (!s_beforeSweepInstalled) {
+        s_prevBeforeSweep = GC_get_before_sweep_callback();
+        GC_set_before_sweep_callback(releaseUnmarkedSamples);
+        s_beforeSweepInstalled = true;
+    }
+}
+
+void AllocationProfiler::stop()
+{
+    // Samples are kept (and still tracked) until the next start(),
+    // so a profile can be dumped after stopping.
+    if (s_profiler) {
+        s_profiler->running = false;
+    }
+    g_bytesUntilNextSample = INTPTR_MAX;
+}
+
+bool AllocationProfiler::isRunning()
+{
+    return s_profiler && s_profiler->running;
+}
+
+bool AllocationProfiler::dump(const char* fileName)
+{
+    FILE* fp = fopen(fileName, "w");
+    if (!fp) {
+        return false;
+    }
+
+    size_t inuseCount = 0, inuseBytes = 0, allocCount = 0, allocBytes = 0;
+    size_t samplingInterval = s_profiler ? s_profiler->samplingInterval : defaultSamplingInterval;
+    if (s_profiler) {
+        for (const auto& record : s_profiler->records) {
+            inuseCount += record.inuseCount;
+            inuseBytes += record.inuseBytes;
+            allocCount += record.allocCount;
+            allocBytes += record.allocBytes;
+        }
+    }
+
+    fprintf(fp, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n",
+            inuseCount, inuseBytes, allocCount, allocBytes, samplingInterval);
+
+    if (s_profiler) {
+        for (const auto& record : s_profiler->records) {
+            fprintf(fp, "%zu: %zu [%zu: %zu] @", record.inuseCount, record.inuseBytes,
+                    record.allocCount, record.allocBytes);
+            for (int i = 0; i < record.stack.depth; i++) {
+                fprintf(fp, " %p", record.stack.frames[i]);
+            }
+            fprintf(fp, "\n");
+        }
+    }
+
+#if defined(__linux__)
+    // pprof needs the memory map to symbolize the addresses.
+    fprintf(fp, "\nMAPPED_LIBRARIES:\n");
+    FILE* maps = fopen("/proc/self/maps", "r");
+    if (maps) {
+        char buffer[4096];
+        size_t length;
+        while ((length = fread(buffer, 1, sizeof(buffer), maps)) > 0) {
+            fwrite(buffer, 1, length, fp);
+        }
+        fclose(maps);
+    }
+#endif
+
+    fclose(fp);
+    return true;
+}
+}
+
+#endif // GCUTIL_ALLOC_PROFILER
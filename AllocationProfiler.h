@@ -0,0 +1,38 @@
+#ifndef __GCUtilAllocationProfiler__
+#define __GCUtilAllocationProfiler__
+
+#ifdef GCUTIL_ALLOC_PROFILER
+
+#include "GCUtil.h"
+
+namespace GCUtil {
+
+// Sampling allocation profiler.
+//
+// Instead of tracking every object, one allocation is sampled on average
+// every `samplingInterval` bytes. The distance between two samples is
+// drawn from an exponential distribution, so every allocated byte has
+// the same chance to be sampled regardless of the allocation pattern.
+// The call stack of a sampled allocation is recorded and the sample is
+// checked after every collection whether it is still alive.
+//
+// The profile is written in the heap_v2 format of gperftools, which can
+// be read by pprof (e.g. `pprof -http=: <binary> <profile>`).
+class AllocationProfiler {
+public:
+    static const size_t defaultSamplingInterval = 512 * 1024;
+    static const int maxStackDepth = 32;
+
+    static void start(size_t samplingInterval = defaultSamplingInterval);
+    static void stop();
+    static bool isRunning();
+
+    // Writes the samples taken since start(). Returns false if the file
+    // cannot be opened.
+    static bool dump(const char* fileName);
+};
+}
+
+#endif // GCUTIL_ALLOC_PROFILER
+
+#endif // __GCUtilAllocationProfiler__
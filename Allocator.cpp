@@ -20,20 +20,36 @@
 #include "GCUtilInternal.h"
 #include "Allocator.h"
 
+#include <cstdio>
+#include <cstring>
 #include <vector>
 #include <algorithm>
 
+namespace GCUtil {
+
+MAY_THREAD_LOCAL void** g_nodeFreeLists = nullptr;
+
+void** gc_node_free_lists_slow()
+{
+    void** lists = (void**)GC_MALLOC_UNCOLLECTABLE(sizeof(void*) * GC_TINY_FREELISTS);
+    RELEASE_ASSERT(lists);
+    memset(lists, 0, sizeof(void*) * GC_TINY_FREELISTS);
+    g_nodeFreeLists = lists;
+    return lists;
+}
+}
+
 #ifdef ESCARGOT_MEM_STATS
-#include <cstring>
-#include <map>
+#include <cstdint>
+#include <unordered_map>
+#include <gc_tiny_fl.h>
 #ifdef ESCARGOT_VALGRIND
 #include <valgrind/valgrind.h>
 #endif
 
 struct AllocInfo {
-    GC_finalization_proc user_cb;
-    void* user_data;
     size_t size;
+    bool live;
 };
 
 struct HeapInfo {
@@ -46,73 +62,222 @@ struct HeapInfo {
     size_t free_count;
 };
 
-// This structure holds information about the size of the
-// allcoated memory area and a finalization user callback
-// with its user defined data.
-std::map<void*, AllocInfo>& addressTable()
-{
-    static MAY_THREAD_LOCAL std::map<void*, AllocInfo> table;
-    return table;
-}
+// Tracked objects of one heap block. Every object in a block has the
+// same size, so the slot of an object is simply its offset from the
+// block start divided by the object size.
+struct BlockInfo {
+    size_t objectSize;
+    int kind;
+    size_t userOffset; // distance between GC_base and the user pointer
+    size_t liveCount;
+    std::vector<AllocInfo> slots;
+};
+
+// This structure holds the size of every allocated memory area keyed by
+// its heap block. Consecutive allocations usually come from the same
+// block, so the last looked up block is cached.
+struct AddressTable {
+    std::unordered_map<uintptr_t, BlockInfo> blocks;
+    uintptr_t cachedKey;
+    BlockInfo* cachedBlock;
+};
+
+static MAY_THREAD_LOCAL AddressTable* s_addressTable = nullptr;
+static MAY_THREAD_LOCAL size_t s_hblkSize = 0;
+static MAY_THREAD_LOCAL GC_before_sweep_proc s_prevBeforeSweep = nullptr;
 
 static MAY_THREAD_LOCAL HeapInfo heapInfo = { 0, 0, 0, 0, 0, 0, 0 };
 
+// Histograms by object kind and by size class in granules. Slot 0 of
+// the size classes holds the large objects.
+static MAY_THREAD_LOCAL GC_usage_info kindUsage[GC_MEM_STATS_MAX_KINDS];
+static MAY_THREAD_LOCAL GC_usage_info* s_sizeClassUsage = nullptr;
+static MAY_THREAD_LOCAL size_t s_sizeClassCount = 0;
+static MAY_THREAD_LOCAL int s_explicitKind = -1;
+
+static void GC_CALLBACK releaseUnmarkedAddresses();
+
 // The addressTable allocation should be in a separated function. This is
 // important, because the noise (helper structiore allcoations) can be
 // filtered out by the Freya tool of Valgrind.
-void createAddressEntry(void* address, size_t size)
+AddressTable& addressTable()
 {
-    auto it = addressTable().find(address);
-    // The address should not exist.
-    assert(it == addressTable().end());
+    if (!s_addressTable) {
+        s_addressTable = new AddressTable();
+        s_addressTable->cachedKey = 0;
+        s_addressTable->cachedBlock = nullptr;
+        s_hblkSize = GC_get_hblk_size();
+        s_sizeClassCount = s_hblkSize / 2 / GC_GRANULE_BYTES + 1;
+        s_sizeClassUsage = new GC_usage_info[s_sizeClassCount]();
+
+        // Dead objects are detected right before sweeping instead of
+        // registering a finalizer on every allocated object.
+        s_prevBeforeSweep = GC_get_before_sweep_callback();
+        GC_set_before_sweep_callback(releaseUnmarkedAddresses);
+    }
+    return *s_addressTable;
+}
+
+static inline void* baseAddress(void* address)
+{
+#if defined(GC_DEBUG)
+    return GC_base(address);
+#else
+    return address;
+#endif
+}
+
+static BlockInfo* findBlock(AddressTable& table, uintptr_t key)
+{
+    if (table.cachedKey == key && table.cachedBlock) {
+        return table.cachedBlock;
+    }
 
-    addressTable()[address] = { nullptr, nullptr, size };
+    auto it = table.blocks.find(key);
+    if (it == table.blocks.end()) {
+        return nullptr;
+    }
+    table.cachedKey = key;
+    table.cachedBlock = &it->second;
+    return table.cachedBlock;
 }
 
-void unregisterGCAddress(void* address, void* data)
+static void eraseBlock(AddressTable& table, uintptr_t key)
 {
-    auto it = addressTable().find(address);
-    // The address should exist.
-    if (it == addressTable().end()) {
-        return;
+    if (table.cachedKey == key) {
+        table.cachedBlock = nullptr;
     }
+    table.blocks.erase(key);
+}
 
-    AllocInfo allocInfo = it->second;
-    // Execute the user defined callback.
-    if (allocInfo.user_cb)
-        allocInfo.user_cb(address, allocInfo.user_data);
+static inline size_t sizeClassIndex(size_t objectSize)
+{
+    size_t granules = objectSize / GC_GRANULE_BYTES;
+    return granules < s_sizeClassCount ? granules : 0;
+}
+
+BlockInfo& createBlockEntry(AddressTable& table, uintptr_t key, size_t objectSize, int kind, size_t userOffset)
+{
+    BlockInfo& block = table.blocks[key];
+    block.objectSize = objectSize;
+    block.kind = kind;
+    block.userOffset = userOffset;
+    block.liveCount = 0;
+    block.slots.assign(objectSize > s_hblkSize / 2 ? 1 : s_hblkSize / objectSize, AllocInfo{ 0, false });
+
+    table.cachedKey = key;
+    table.cachedBlock = &block;
+    return block;
+}
+
+static void releaseSlot(BlockInfo& block, size_t index, void* address)
+{
+    AllocInfo& allocInfo = block.slots[index];
 
     heapInfo.allocated -= allocInfo.size;
     heapInfo.free_count++;
 
-    addressTable().erase(it);
+    GC_usage_info& kindInfo = kindUsage[block.kind];
+    kindInfo.allocated -= allocInfo.size;
+    kindInfo.free_count++;
+
+    GC_usage_info& sizeInfo = s_sizeClassUsage[sizeClassIndex(block.objectSize)];
+    sizeInfo.allocated -= allocInfo.size;
+    sizeInfo.free_count++;
+
+    allocInfo.live = false;
+    block.liveCount--;
 
 #ifdef ESCARGOT_VALGRIND
     VALGRIND_FREELIKE_BLOCK(address, 0);
-#endif
-    // Unregister the callback function. This is necessary if an address have a
-    // registered finalizer function, but the memory area is explicitly deallocated
-    // by GC_FREE.
-#if defined(GC_DEBUG)
-    GC_debug_register_finalizer_no_order(address, nullptr, nullptr, nullptr, nullptr);
-#else
-    GC_register_finalizer_no_order(address, nullptr, nullptr, nullptr, nullptr);
 #endif
 }
 
+void unregisterGCAddress(void* address)
+{
+    AddressTable& table = addressTable();
+    uintptr_t base = (uintptr_t)baseAddress(address);
+    uintptr_t key = base & ~(uintptr_t)(s_hblkSize - 1);
+    BlockInfo* block = findBlock(table, key);
+    // The address should exist.
+    if (!block) {
+        return;
+    }
+
+    size_t index = (base - key) / block->objectSize;
+    if (index >= block->slots.size() || !block->slots[index].live) {
+        return;
+    }
+
+    releaseSlot(*block, index, address);
+    if (!block->liveCount) {
+        eraseBlock(table, key);
+    }
+}
+
+// Called by the collector after marking. Every tracked object which is
+// still unmarked is reclaimed by the upcoming sweep.
+static void GC_CALLBACK releaseUnmarkedAddresses()
+{
+    AddressTable& table = addressTable();
+    table.cachedBlock = nullptr;
+
+    for (auto it = table.blocks.begin(); it != table.blocks.end();) {
+        BlockInfo& block = it->second;
+        size_t slotCount = block.slots.size();
+        for (size_t i = 0; i < slotCount; i++) {
+            if (!block.slots[i].live) {
+                continue;
+            }
+            char* base = (char*)it->first + i * block.objectSize;
+            if (!GC_is_marked(base)) {
+                releaseSlot(block, i, base + block.userOffset);
+            }
+        }
+
+        if (!block.liveCount) {
+            it = table.blocks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (s_prevBeforeSweep) {
+        s_prevBeforeSweep();
+    }
+}
+
 void registerGCAddress(void* address, size_t siz)
 {
-    auto it = addressTable().find(address);
+    AddressTable& table = addressTable();
+    uintptr_t base = (uintptr_t)baseAddress(address);
+    uintptr_t key = base & ~(uintptr_t)(s_hblkSize - 1);
+    size_t objectSize;
+    int kind = GC_get_kind_and_size(address, &objectSize);
+    assert(kind < GC_MEM_STATS_MAX_KINDS);
+
+    BlockInfo* block = findBlock(table, key);
+    if (!block || block->objectSize != objectSize || block->kind != kind) {
+        // A block whose objects were all released may be reused for
+        // another object size before the entry is dropped.
+        assert(!block || !block->liveCount);
+        block = &createBlockEntry(table, key, objectSize, kind, (uintptr_t)address - base);
+    }
+
+    size_t index = (base - key) / objectSize;
+    AllocInfo& allocInfo = block->slots[index];
     // The address should not exist.
-    assert(it == addressTable().end());
+    assert(!allocInfo.live);
 
-    createAddressEntry(address, siz);
+    allocInfo.size = siz;
+    allocInfo.live = true;
+    block->liveCount++;
 
 #ifdef ESCARGOT_VALGRIND
     VALGRIND_MALLOCLIKE_BLOCK(address, siz, 0, 0);
 #endif
     // Calculate statistics.
-    size_t waste = GC_size(address) - siz;
+    size_t waste = objectSize - siz;
 
     heapInfo.total_waste += waste;
     heapInfo.allocated += siz;
@@ -125,14 +290,60 @@ void registerGCAddress(void* address, size_t siz)
     if (heapInfo.allocated > heapInfo.peak_allocated)
         heapInfo.peak_allocated = heapInfo.allocated;
 
-    // Register finalizer callback for all allocated memory addresses.
-    // In this case a notification happens before deallocating the
-    // memory area by the GC.
-#if defined(GC_DEBUG)
-    GC_debug_register_finalizer_no_order(address, unregisterGCAddress, nullptr, nullptr, nullptr);
-#else
-    GC_register_finalizer_no_order(address, unregisterGCAddress, nullptr, nullptr, nullptr);
+    GC_usage_info* usages[2] = { &kindUsage[kind], &s_sizeClassUsage[sizeClassIndex(objectSize)] };
+    for (GC_usage_info* usage : usages) {
+        usage->alloc_count++;
+        usage->allocated += siz;
+        usage->total_allocated += siz;
+        usage->total_waste += waste;
+    }
+}
+
+void GC_get_kind_usage(unsigned kind, GC_usage_info* info)
+{
+    RELEASE_ASSERT(kind < GC_MEM_STATS_MAX_KINDS);
+    *info = kindUsage[kind];
+}
+
+size_t GC_get_size_class_count()
+{
+    addressTable();
+    return s_sizeClassCount;
+}
+
+void GC_get_size_class_usage(size_t granules, GC_usage_info* info)
+{
+    RELEASE_ASSERT(granules < GC_get_size_class_count());
+    *info = s_sizeClassUsage[granules];
+}
+
+static const char* kindName(unsigned kind)
+{
+    if ((int)kind == s_explicitKind)
+        return "explicitly typed";
+
+    // Predefined kinds of bdwgc (see PTRFREE, NORMAL, etc. in gc_priv.h).
+    switch (kind) {
+    case 0:
+        return "atomic";
+    case 1:
+        return "normal";
+    case 2:
+        return "uncollectable";
+#ifdef GC_ATOMIC_UNCOLLECTABLE
+    case 3:
+        return "atomic uncollectable";
 #endif
+    default:
+        return "custom";
+    }
+}
+
+static void printUsage(const GC_usage_info& info)
+{
+    printf("count %zu, freed %zu, live %zu bytes, total %zu bytes, waste %zu bytes\n",
+           info.alloc_count, info.free_count, info.allocated,
+           info.total_allocated, info.total_waste);
 }
 
 void GC_print_heap_usage()
@@ -145,21 +356,42 @@ void GC_print_heap_usage()
     printf("  Leak: %zu bytes\n", heapInfo.allocated);
     printf("  Allocation count: %zu\n", heapInfo.alloc_count);
     printf("  Free count: %zu\n", heapInfo.free_count);
+
+    printf("  By kind:\n");
+    for (unsigned kind = 0; kind < GC_MEM_STATS_MAX_KINDS; kind++) {
+        if (!kindUsage[kind].alloc_count)
+            continue;
+        printf("    [%u] %s: ", kind, kindName(kind));
+        printUsage(kindUsage[kind]);
+    }
+
+    printf("  By size class:\n");
+    for (size_t granules = 1; granules <= s_sizeClassCount; granules++) {
+        // The large objects (slot 0) are printed last.
+        size_t index = granules % s_sizeClassCount;
+        if (!s_sizeClassUsage || !s_sizeClassUsage[index].alloc_count)
+            continue;
+        if (index) {
+            printf("    %zu bytes: ", index * GC_GRANULE_BYTES);
+        } else {
+            printf("    large: ");
+        }
+        printUsage(s_sizeClassUsage[index]);
+    }
 }
 
-// This function saves the used defined callback and data for the pointer.
-// There are GC_REGISTER_FINALIZER_NO_ORDER usages within Escargot (e.g.
-// in the ByteCode.h file).
+// Object lifetime is tracked without finalizers, so the user defined
+// callbacks (e.g. in the ByteCode.h file of Escargot) can be registered
+// as they are.
 void GC_register_finalizer_no_order_hook(void* obj, GC_finalization_proc fn,
                                          void* cd, GC_finalization_proc *ofn,
                                          void** ocd)
 {
-    auto it = addressTable().find(obj);
-    // The address should exist.
-    assert(it != addressTable().end());
-
-    (it->second).user_cb = fn;
-    (it->second).user_data = cd;
+#if defined(GC_DEBUG)
+    GC_debug_register_finalizer_no_order(obj, fn, cd, ofn, ocd);
+#else
+    GC_register_finalizer_no_order(obj, fn, cd, ofn, ocd);
+#endif
 }
 
 void* GC_malloc_hook(size_t siz)
@@ -212,6 +444,8 @@ void* GC_malloc_explicitly_typed_hook(size_t siz, GC_descr desc)
     void* ptr = GC_debug_malloc(siz, GC_EXTRAS);
 #else
     void* ptr = GC_malloc_explicitly_typed(siz, desc);
+    if (ptr && s_explicitKind < 0)
+        s_explicitKind = GC_get_kind_and_size(ptr, nullptr);
 #endif
     registerGCAddress(ptr, siz);
     return ptr;
@@ -250,9 +484,9 @@ void* GC_strdup_hook(const char* str)
     return ptr;
 }
 
-void* GC_strndup_hook(const char* str)
+void* GC_strndup_hook(const char* str, size_t siz)
 {
-    size_t len = std::strlen(str);
+    size_t len = strnlen(str, siz);
 #if defined(GC_DEBUG)
     void* ptr = GC_debug_strndup(str, len, GC_EXTRAS);
 #else
@@ -265,7 +499,7 @@ void* GC_strndup_hook(const char* str)
 void* GC_realloc_hook(void* address, size_t siz)
 {
     if (address) {
-        unregisterGCAddress(address, nullptr);
+        unregisterGCAddress(address);
     }
 #if defined(GC_DEBUG)
     void* ptr = GC_debug_realloc(address, siz, GC_EXTRAS);
@@ -283,7 +517,7 @@ void GC_free_hook(void* address)
     if (!address) {
         return;
     }
-    unregisterGCAddress(address, nullptr);
+    unregisterGCAddress(address);
 #if defined(GC_DEBUG)
     GC_debug_free(address);
 #else
@@ -44,9 +44,43 @@
 #define __GCutilAllocator__
 
 #include "GCUtil.h"
+#include "GCUtilInternal.h"
+#include <gc_inline.h>
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace GCUtil {
 
+#if defined(__cpp_lib_allocate_at_least) && __cpp_lib_allocate_at_least >= 202302L
+template <class GC_Tp>
+using gc_allocation_result = std::allocation_result<GC_Tp*, size_t>;
+#else
+// Same as std::allocation_result of C++23
+template <class GC_Tp>
+struct gc_allocation_result {
+    GC_Tp* ptr;
+    size_t count;
+};
+#endif
+
+// Number of GC_Tp elements which fit into the object at GC_p. Objects are
+// rounded up to the granule size, so this can be larger than requested.
+// The extra byte kept at the end with all interior pointers is not usable.
+template <class GC_Tp>
+inline size_t gc_usable_count(void* GC_p, size_t GC_n)
+{
+#if defined(GC_DEBUG)
+    // GC_size includes the debug header.
+    return GC_n;
+#else
+    return GC_p ? (GC_size(GC_p) - (GC_get_all_interior_pointers() ? 1 : 0)) / sizeof(GC_Tp) : GC_n;
+#endif
+}
+
 template <class GC_Tp>
 class gc_malloc_allocator {
 public:
@@ -58,6 +92,13 @@ public:
     typedef const GC_Tp& const_reference;
     typedef GC_Tp value_type;
 
+    // The allocator has no state, so containers never need to compare
+    // or reallocate when they are assigned or swapped.
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    typedef std::true_type is_always_equal;
+
     template <class GC_Tp1>
     struct rebind {
         typedef gc_malloc_allocator<GC_Tp1> other;
@@ -83,11 +124,20 @@ public:
         return (GC_Tp*)GC_MALLOC(sizeof(GC_Tp) * GC_n);
     }
 
+    // Returns the whole granule-rounded object, so containers can use
+    // the slack as capacity.
+    gc_allocation_result<GC_Tp> allocate_at_least(size_type GC_n)
+    {
+        GC_Tp* GC_p = allocate(GC_n);
+        return gc_allocation_result<GC_Tp>{ GC_p, gc_usable_count<GC_Tp>(GC_p, GC_n) };
+    }
+
     // __p is not permitted to be a null pointer.
-    void deallocate(pointer __p, size_type)
+    // GC_n is either the requested count or the count returned by
+    // allocate_at_least; it is only checked against the block header.
+    void deallocate(pointer __p, size_type GC_n)
     {
-        // memset(__p, 0, GC_n * sizeof(GC_Tp));
-        GC_FREE(__p);
+        GC_FREE_SIZED(__p, sizeof(GC_Tp) * GC_n, GC_I_NORMAL);
     }
 
     // __p is not permitted to be a null pointer.
@@ -98,7 +148,11 @@ public:
 
     size_type max_size() const throw() { return size_t(-1) / sizeof(GC_Tp); }
     void construct(pointer __p, const GC_Tp& __val) { new (__p) GC_Tp(__val); }
+    template <class GC_Tp1, class... GC_Args>
+    void construct(GC_Tp1* __p, GC_Args&&... __args) { ::new ((void*)__p) GC_Tp1(std::forward<GC_Args>(__args)...); }
     void destroy(pointer __p) { __p->~GC_Tp(); }
+    template <class GC_Tp1>
+    void destroy(GC_Tp1* __p) { __p->~GC_Tp1(); }
 };
 
 template <>
@@ -139,6 +193,11 @@ public:
     typedef const GC_Tp& const_reference;
     typedef GC_Tp value_type;
 
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    typedef std::true_type is_always_equal;
+
     template <class GC_Tp1>
     struct rebind {
         typedef gc_malloc_atomic_allocator<GC_Tp1> other;
@@ -164,11 +223,21 @@ public:
         return (GC_Tp*)GC_MALLOC_ATOMIC(sizeof(GC_Tp) * GC_n);
     }
 
+    gc_allocation_result<GC_Tp> allocate_at_least(size_type GC_n)
+    {
+        GC_Tp* GC_p = allocate(GC_n);
+        return gc_allocation_result<GC_Tp>{ GC_p, gc_usable_count<GC_Tp>(GC_p, GC_n) };
+    }
+
     // __p is not permitted to be a null pointer.
-    void deallocate(pointer __p, size_type) { GC_FREE(__p); }
+    void deallocate(pointer __p, size_type GC_n) { GC_FREE_SIZED(__p, sizeof(GC_Tp) * GC_n, GC_I_PTRFREE); }
     size_type max_size() const throw() { return size_t(-1) / sizeof(GC_Tp); }
     void construct(pointer __p, const GC_Tp& __val) { new (__p) GC_Tp(__val); }
+    template <class GC_Tp1, class... GC_Args>
+    void construct(GC_Tp1* __p, GC_Args&&... __args) { ::new ((void*)__p) GC_Tp1(std::forward<GC_Args>(__args)...); }
     void destroy(pointer __p) { __p->~GC_Tp(); }
+    template <class GC_Tp1>
+    void destroy(GC_Tp1* __p) { __p->~GC_Tp1(); }
 };
 
 template <>
@@ -199,6 +268,133 @@ inline bool operator!=(const gc_malloc_atomic_allocator<GC_T1>&, const gc_malloc
 }
 
 
+// Free lists of gc_node_allocator indexed by granules, like the tiny free
+// lists of gc_inline.h. They live in an uncollectable object, so the
+// cached nodes are traced and stay allocated.
+extern MAY_THREAD_LOCAL void** g_nodeFreeLists;
+void** gc_node_free_lists_slow();
+
+inline void** gc_node_free_lists()
+{
+    void** GC_lists = g_nodeFreeLists;
+    if (GC_EXPECT(!GC_lists, 0)) {
+        GC_lists = gc_node_free_lists_slow();
+    }
+    return GC_lists;
+}
+
+#if defined(GC_DEBUG) || defined(ESCARGOT_MEM_STATS) || defined(GCUTIL_ALLOC_PROFILER)
+// Every node needs its debug header or has to be seen by the hooks.
+#define GC_NO_NODE_POOL
+#endif
+
+// Allocates a small NORMAL object from the node free lists. An empty list
+// is refilled with a whole chain of objects by GC_generic_malloc_many, so
+// most allocations neither take the lock nor touch the collector.
+inline void* gc_node_malloc(size_t GC_bytes)
+{
+#if defined(GC_NO_NODE_POOL)
+    return GC_MALLOC(GC_bytes);
+#else
+    void* GC_result;
+    GC_MALLOC_WORDS_KIND(GC_result, (GC_bytes + sizeof(GC_word) - 1) / sizeof(GC_word),
+                         gc_node_free_lists(), GC_I_NORMAL, *(void**)GC_result = 0);
+    return GC_result;
+#endif
+}
+
+// Puts a node which is known to be unreachable back onto its free list
+// instead of freeing it.
+inline void gc_node_recycle(void* GC_p, size_t GC_bytes)
+{
+#if defined(GC_NO_NODE_POOL)
+    GC_FREE_SIZED(GC_p, GC_bytes, GC_I_NORMAL);
+#else
+    size_t GC_granules = GC_WORDS_TO_WHOLE_GRANULES((GC_bytes + sizeof(GC_word) - 1) / sizeof(GC_word));
+    if (GC_granules >= GC_TINY_FREELISTS) {
+        GC_FREE_SIZED(GC_p, GC_bytes, GC_I_NORMAL);
+        return;
+    }
+    // Cached objects must be cleared, as if they came from the collector.
+    memset(GC_p, 0, GC_granules ? GC_granules * GC_GRANULE_BYTES : GC_GRANULE_BYTES);
+    void** GC_list = gc_node_free_lists() + GC_granules;
+    *(void**)GC_p = *GC_list;
+    *GC_list = GC_p;
+#endif
+}
+
+// Allocator for the nodes of std::list, std::map, std::unordered_map, ...
+// Single nodes come from gc_node_malloc, arrays (e.g. bucket arrays)
+// from GC_MALLOC. If GC_recycle is set, deallocated nodes are cached for
+// the next allocation of the same size instead of being freed.
+template <class GC_Tp, bool GC_recycle = false>
+class gc_node_allocator {
+public:
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef GC_Tp* pointer;
+    typedef const GC_Tp* const_pointer;
+    typedef GC_Tp& reference;
+    typedef const GC_Tp& const_reference;
+    typedef GC_Tp value_type;
+
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    typedef std::true_type is_always_equal;
+
+    template <class GC_Tp1>
+    struct rebind {
+        typedef gc_node_allocator<GC_Tp1, GC_recycle> other;
+    };
+
+    gc_node_allocator() throw() {}
+    gc_node_allocator(const gc_node_allocator&) throw() {}
+    template <class GC_Tp1>
+    gc_node_allocator(const gc_node_allocator<GC_Tp1, GC_recycle>&) throw() {}
+    ~gc_node_allocator() throw()
+    {
+    }
+
+    pointer address(reference GC_x) const { return &GC_x; }
+    const_pointer address(const_reference GC_x) const { return &GC_x; }
+    GC_Tp* allocate(size_type GC_n, const void* = 0)
+    {
+        if (GC_EXPECT(GC_n == 1, 1)) {
+            return (GC_Tp*)gc_node_malloc(sizeof(GC_Tp));
+        }
+        return (GC_Tp*)GC_MALLOC(sizeof(GC_Tp) * GC_n);
+    }
+
+    // __p is not permitted to be a null pointer.
+    void deallocate(pointer __p, size_type GC_n)
+    {
+        if (GC_recycle && GC_n == 1) {
+            gc_node_recycle(__p, sizeof(GC_Tp));
+        } else {
+            GC_FREE_SIZED(__p, sizeof(GC_Tp) * GC_n, GC_I_NORMAL);
+        }
+    }
+
+    size_type max_size() const throw() { return size_t(-1) / sizeof(GC_Tp); }
+    template <class GC_Tp1, class... GC_Args>
+    void construct(GC_Tp1* __p, GC_Args&&... __args) { ::new ((void*)__p) GC_Tp1(std::forward<GC_Args>(__args)...); }
+    template <class GC_Tp1>
+    void destroy(GC_Tp1* __p) { __p->~GC_Tp1(); }
+};
+
+template <class GC_T1, class GC_T2, bool GC_recycle>
+inline bool operator==(const gc_node_allocator<GC_T1, GC_recycle>&, const gc_node_allocator<GC_T2, GC_recycle>&)
+{
+    return true;
+}
+
+template <class GC_T1, class GC_T2, bool GC_recycle>
+inline bool operator!=(const gc_node_allocator<GC_T1, GC_recycle>&, const gc_node_allocator<GC_T2, GC_recycle>&)
+{
+    return false;
+}
+
 }
 
 #endif
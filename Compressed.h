@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+#ifndef __GCUtilCompressed__
+#define __GCUtilCompressed__
+
+#include "GCUtil.h"
+#include "GCUtilInternal.h"
+#include "TypedAllocation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#ifdef GC_COMPRESSED_POINTERS
+
+namespace GCUtil {
+
+// A GC pointer stored as its 32-bit offset from the base of the heap
+// window (GC_compressed_base, see gc.h). It is meant for the members of
+// objects allocated with CompressedTypedAllocation, the only heap
+// objects in which the collector follows compressed pointers (the
+// stacks are scanned for them too, but not the static data). The window
+// belongs to the heap of the current thread, so a compressed pointer
+// must not be decompressed by another heap.
+template <typename T>
+class Compressed {
+public:
+    Compressed(T* value = nullptr)
+        : m_value(compress(value))
+    {
+    }
+
+    Compressed& operator=(T* value)
+    {
+        m_value = compress(value);
+        return *this;
+    }
+
+    T* get() const { return static_cast<T*>(GC_DECOMPRESS_PTR(m_value)); }
+    T* operator->() const { return get(); }
+    T& operator*() const { return *get(); }
+    operator T*() const { return get(); }
+
+    uint32_t offset() const { return m_value; }
+
+private:
+    static uint32_t compress(T* value)
+    {
+        assert(!value || ((char*)value > GC_compressed_base && (uint64_t)((char*)value - GC_compressed_base) <= UINT32_MAX));
+        return GC_COMPRESS_PTR(value);
+    }
+
+    uint32_t m_value;
+};
+
+// Word `index` of the GC_make_compressed_descriptor bitmap which has a
+// bit set for every 32-bit slot at the given byte offsets.
+constexpr GC_word gc_compressed_bitmap_word(size_t)
+{
+    return 0;
+}
+
+template <typename... Offsets>
+constexpr GC_word gc_compressed_bitmap_word(size_t index, size_t offset, Offsets... offsets)
+{
+    return ((offset / sizeof(uint32_t)) / GC_WORDSZ == index ? (GC_word)1 << ((offset / sizeof(uint32_t)) % GC_WORDSZ) : 0)
+        | gc_compressed_bitmap_word(index, offsets...);
+}
+
+constexpr bool gc_compressed_offsets_valid(size_t, size_t)
+{
+    return true;
+}
+
+template <typename... Offsets>
+constexpr bool gc_compressed_offsets_valid(size_t size, size_t minOffset, size_t offset, Offsets... offsets)
+{
+    return offset % sizeof(uint32_t) == 0 && offset >= minOffset && offset + sizeof(uint32_t) <= size
+        && gc_compressed_offsets_valid(size, offset + sizeof(uint32_t), offsets...);
+}
+
+// Allocates objects of type T whose only GC pointers are the Compressed
+// members at the given byte offsets (use offsetof), e.g.
+//
+//   typedef CompressedTypedAllocation<Node, offsetof(Node, m_next), offsetof(Node, m_value)> NodeAllocation;
+//   Node* node = NodeAllocation::create(...);
+//
+// Like TypedAllocation, but the descriptor describes 32-bit slots.
+template <typename T, size_t... PointerOffsets>
+class CompressedTypedAllocation {
+public:
+    static const size_t slotCount = sizeof(T) / sizeof(uint32_t);
+    static const size_t pointerCount = sizeof...(PointerOffsets);
+
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0, "The size of the type should be a multiple of 4");
+    static_assert(gc_compressed_offsets_valid(sizeof(T), 0, PointerOffsets...), "Pointer offsets should be ascending, 4-byte aligned and inside the type");
+
+    static GC_descr descriptor()
+    {
+        if (GC_EXPECT(!s_descriptor, 0)) {
+            s_descriptor = makeDescriptor();
+        }
+        return s_descriptor;
+    }
+
+    // Returns uninitialized storage for one T.
+    static void* allocate()
+    {
+        void* ptr;
+        if (!pointerCount) {
+            ptr = GC_MALLOC_ATOMIC(sizeof(T));
+        } else {
+            // Not GC_MALLOC_EXPLICITLY_TYPED: under GC_DEBUG it drops the
+            // descriptor, and the compressed slots would not be followed.
+            ptr = GC_malloc_explicitly_typed(sizeof(T), descriptor());
+        }
+        RELEASE_ASSERT(ptr);
+        return ptr;
+    }
+
+    template <typename... Args>
+    static T* create(Args&&... args)
+    {
+        return new (allocate()) T(std::forward<Args>(args)...);
+    }
+
+private:
+    static GC_descr makeDescriptor()
+    {
+        return makeDescriptor(typename gc_make_index_sequence<(slotCount + GC_WORDSZ - 1) / GC_WORDSZ>::type());
+    }
+
+    template <size_t... Indexes>
+    static GC_descr makeDescriptor(gc_index_sequence<Indexes...>)
+    {
+        GC_word bitmap[] = { gc_compressed_bitmap_word(Indexes, PointerOffsets...)... };
+        return GC_make_compressed_descriptor(bitmap, slotCount);
+    }
+
+    // The mark procedure of the descriptors is registered per heap.
+    static MAY_THREAD_LOCAL GC_descr s_descriptor;
+};
+
+template <typename T, size_t... PointerOffsets>
+MAY_THREAD_LOCAL GC_descr CompressedTypedAllocation<T, PointerOffsets...>::s_descriptor = 0;
+}
+
+#endif
+
+#endif
@@ -43,6 +43,26 @@ void GC_register_finalizer_no_order_hook(void* obj, GC_finalization_proc fn,
                                          void** ocd);
 void GC_print_heap_usage();
 
+// Allocation statistics of one object kind or size class.
+struct GC_usage_info {
+    size_t alloc_count;
+    size_t free_count;
+    size_t allocated; // requested bytes which are still alive
+    size_t total_allocated;
+    size_t total_waste;
+};
+
+#define GC_MEM_STATS_MAX_KINDS 32
+
+// Kinds are the ones returned by GC_get_kind_and_size, including the
+// explicitly typed kind and custom kinds made by GC_new_kind.
+void GC_get_kind_usage(unsigned kind, GC_usage_info* info);
+
+// Size classes are indexed by object size in granules. Index 0 collects
+// the objects which are larger than the largest small size class.
+size_t GC_get_size_class_count();
+void GC_get_size_class_usage(size_t granules, GC_usage_info* info);
+
 #undef GC_MALLOC_EXPLICITLY_TYPED
 #define GC_MALLOC_EXPLICITLY_TYPED(bytes, d) GC_malloc_explicitly_typed_hook(bytes, d)
 
@@ -79,11 +99,101 @@ void GC_print_heap_usage();
 #undef GC_FREE
 #define GC_FREE(X) GC_free_hook(X)
 
+#undef GC_FREE_SIZED
+#define GC_FREE_SIZED(X, siz, kind) GC_free_hook(X)
+
 #undef GC_REGISTER_FINALIZER_NO_ORDER
 #define GC_REGISTER_FINALIZER_NO_ORDER(p, f, d, of, od) GC_register_finalizer_no_order_hook(p, f, d, of, od);
 
 #endif
 
+#ifdef GCUTIL_ALLOC_PROFILER
+#ifdef ESCARGOT_MEM_STATS
+#error "GCUTIL_ALLOC_PROFILER cannot be combined with ESCARGOT_MEM_STATS"
+#endif
+
+#include "GCUtilInternal.h"
+#include <stdint.h>
+
+namespace GCUtil {
+// Number of bytes which can still be allocated before the next sample
+// is taken. See AllocationProfiler.h for details.
+extern MAY_THREAD_LOCAL intptr_t g_bytesUntilNextSample;
+void sampleAllocation(void* ptr, size_t siz);
+void forgetSampledAllocation(void* ptr);
+}
+
+inline void* GC_sampled_allocation(void* ptr, size_t siz)
+{
+    GCUtil::g_bytesUntilNextSample -= (intptr_t)siz;
+    if (GCUtil::g_bytesUntilNextSample < 0 && ptr) {
+        GCUtil::sampleAllocation(ptr, siz);
+    }
+    return ptr;
+}
+
+// These are defined before the macros below are replaced, so they
+// expand to the original (release or debug) allocators.
+inline void* GC_malloc_sampled(size_t siz) { return GC_sampled_allocation(GC_MALLOC(siz), siz); }
+inline void* GC_malloc_atomic_sampled(size_t siz) { return GC_sampled_allocation(GC_MALLOC_ATOMIC(siz), siz); }
+inline void* GC_malloc_uncollectable_sampled(size_t siz) { return GC_sampled_allocation(GC_MALLOC_UNCOLLECTABLE(siz), siz); }
+inline void* GC_malloc_atomic_uncollectable_sampled(size_t siz) { return GC_sampled_allocation(GC_MALLOC_ATOMIC_UNCOLLECTABLE(siz), siz); }
+inline void* GC_malloc_explicitly_typed_sampled(size_t siz, GC_descr d) { return GC_sampled_allocation(GC_MALLOC_EXPLICITLY_TYPED(siz, d), siz); }
+inline void* GC_generic_malloc_sampled(size_t siz, int kind) { return GC_sampled_allocation(GC_GENERIC_MALLOC(siz, kind), siz); }
+
+inline void* GC_realloc_sampled(void* address, size_t siz)
+{
+    if (address) {
+        GCUtil::forgetSampledAllocation(address);
+    }
+    return GC_sampled_allocation(GC_REALLOC(address, siz), siz);
+}
+
+inline void GC_free_sampled(void* address)
+{
+    if (address) {
+        GCUtil::forgetSampledAllocation(address);
+    }
+    GC_FREE(address);
+}
+
+inline void GC_free_sized_sampled(void* address, size_t siz, int kind)
+{
+    if (address) {
+        GCUtil::forgetSampledAllocation(address);
+    }
+    GC_FREE_SIZED(address, siz, kind);
+}
+
+#undef GC_MALLOC
+#define GC_MALLOC(X) GC_malloc_sampled(X)
+
+#undef GC_MALLOC_ATOMIC
+#define GC_MALLOC_ATOMIC(X) GC_malloc_atomic_sampled(X)
+
+#undef GC_MALLOC_UNCOLLECTABLE
+#define GC_MALLOC_UNCOLLECTABLE(siz) GC_malloc_uncollectable_sampled(siz)
+
+#undef GC_MALLOC_ATOMIC_UNCOLLECTABLE
+#define GC_MALLOC_ATOMIC_UNCOLLECTABLE(sz) GC_malloc_atomic_uncollectable_sampled(sz)
+
+#undef GC_MALLOC_EXPLICITLY_TYPED
+#define GC_MALLOC_EXPLICITLY_TYPED(bytes, d) GC_malloc_explicitly_typed_sampled(bytes, d)
+
+#undef GC_GENERIC_MALLOC
+#define GC_GENERIC_MALLOC(siz, kind) GC_generic_malloc_sampled(siz, kind)
+
+#undef GC_REALLOC
+#define GC_REALLOC(address, siz) GC_realloc_sampled(address, siz)
+
+#undef GC_FREE
+#define GC_FREE(X) GC_free_sampled(X)
+
+#undef GC_FREE_SIZED
+#define GC_FREE_SIZED(X, siz, kind) GC_free_sized_sampled(X, siz, kind)
+
+#endif
+
 /* FIXME
  * This is just a workaround to remove ignore_off_page allocator.
  * `ignore_off_page` should be removed from everywhere after stablization.
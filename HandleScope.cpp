@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+#include "HandleScope.h"
+
+#include <cstdio>
+
+namespace GCUtil {
+
+MAY_THREAD_LOCAL HandleScope::Data HandleScope::s_data;
+
+void HandleScope::addChunk()
+{
+    Chunk* chunk = s_data.spare;
+    if (chunk) {
+        s_data.spare = nullptr;
+    } else {
+        chunk = (Chunk*)malloc(sizeof(Chunk));
+        RELEASE_ASSERT(chunk);
+    }
+    chunk->prev = s_data.chunk;
+    s_data.chunk = chunk;
+    s_data.next = chunk->slots;
+    s_data.limit = chunk->slots + ChunkSlots;
+}
+
+void HandleScope::releaseChunks(void** limit)
+{
+    // The chunks taken after the scope was entered are full except the
+    // last one.
+    while (s_data.limit != limit) {
+        Chunk* chunk = s_data.chunk;
+        s_data.chunk = chunk->prev;
+        s_data.limit = s_data.chunk ? s_data.chunk->slots + ChunkSlots : nullptr;
+        if (s_data.spare) {
+            free(s_data.spare);
+        }
+        s_data.spare = chunk;
+    }
+}
+
+size_t HandleScope::handleCount()
+{
+    size_t count = 0;
+    for (Chunk* chunk = s_data.chunk; chunk; chunk = chunk->prev) {
+        count += chunk == s_data.chunk ? s_data.next - chunk->slots : ChunkSlots;
+    }
+    return count;
+}
+
+void HandleScope::pushRoots()
+{
+    for (Chunk* chunk = s_data.chunk; chunk; chunk = chunk->prev) {
+        void** end = chunk == s_data.chunk ? s_data.next : chunk->slots + ChunkSlots;
+        GC_push_all_eager(chunk->slots, end);
+    }
+    if (s_data.stackBoundary) {
+        GC_push_stack_below(s_data.stackBoundary);
+    }
+}
+
+void GC_CALLBACK HandleScope::markStack()
+{
+    pushRoots();
+}
+
+void HandleScope::enablePreciseStackRoots()
+{
+    GC_register_mark_stack_func(markStack);
+}
+
+void HandleScope::disablePreciseStackRoots()
+{
+    GC_register_mark_stack_func(nullptr);
+}
+}
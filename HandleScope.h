@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+#ifndef __GCUtilHandleScope__
+#define __GCUtilHandleScope__
+
+#include "GCUtil.h"
+#include "GCUtilInternal.h"
+
+#include <cstddef>
+
+namespace GCUtil {
+
+// Precise stack roots. Once enablePreciseStackRoots is called, the
+// collector of the current heap no longer scans the native stack;
+// the roots on the stack are the slots of the live handles instead.
+// A Handle takes a slot of the innermost HandleScope, and the slots are
+// released all at once when the scope is left, so handles must not
+// outlive their scope.
+//
+// The slots are kept in chunks allocated with malloc, which only the
+// mark stack function of the heap (pushRoots) scans. Outside the precise
+// mode, the handles are still valid but the native stack is scanned as
+// usual.
+class HandleScope {
+public:
+    static const size_t ChunkSlots = 255;
+
+    struct Chunk {
+        Chunk* prev;
+        void* slots[ChunkSlots];
+    };
+
+    struct Data {
+        void** next; // first free slot of the current chunk
+        void** limit; // end of the current chunk
+        Chunk* chunk;
+        Chunk* spare; // an emptied chunk kept for the next scope
+        void* stackBoundary; // see ConservativeStackScope
+        size_t depth;
+    };
+
+    HandleScope()
+        : m_prevNext(s_data.next)
+        , m_prevLimit(s_data.limit)
+    {
+        s_data.depth++;
+    }
+
+    ~HandleScope()
+    {
+        if (s_data.limit != m_prevLimit) {
+            releaseChunks(m_prevLimit);
+        }
+        s_data.next = m_prevNext;
+        s_data.depth--;
+    }
+
+    static void** allocateSlot()
+    {
+        assert(s_data.depth > 0);
+        if (s_data.next == s_data.limit) {
+            addChunk();
+        }
+        return s_data.next++;
+    }
+
+    // The number of slots taken by the handles of all the live scopes.
+    static size_t handleCount();
+
+    // Replaces the scanning of the native stack of the current heap with
+    // pushRoots. This registers a GC_mark_stack_func, so it should not
+    // be combined with another one (which can call pushRoots itself).
+    static void enablePreciseStackRoots();
+    static void disablePreciseStackRoots();
+
+    // Pushes the slots of the live handles, and the part of the native
+    // stack below the boundary of the outermost ConservativeStackScope.
+    static void pushRoots();
+
+private:
+    HandleScope(const HandleScope&) = delete;
+    HandleScope& operator=(const HandleScope&) = delete;
+
+    static void addChunk();
+    static void releaseChunks(void** limit);
+    static void GC_CALLBACK markStack();
+
+    friend class ConservativeStackScope;
+    static MAY_THREAD_LOCAL Data s_data;
+
+    void** m_prevNext;
+    void** m_prevLimit;
+};
+
+// A GC pointer rooted by a slot of the innermost HandleScope.
+template <typename T>
+class Handle {
+public:
+    Handle(T* value = nullptr)
+        : m_slot(HandleScope::allocateSlot())
+    {
+        *m_slot = (void*)value;
+    }
+
+    // The copy takes its own slot in the innermost scope, so assigning
+    // to it does not change other.
+    Handle(const Handle& other)
+        : m_slot(HandleScope::allocateSlot())
+    {
+        *m_slot = *other.m_slot;
+    }
+
+    Handle& operator=(T* value)
+    {
+        *m_slot = (void*)value;
+        return *this;
+    }
+
+    Handle& operator=(const Handle& other)
+    {
+        *m_slot = *other.m_slot;
+        return *this;
+    }
+
+    T* get() const { return static_cast<T*>(*m_slot); }
+    T* operator->() const { return get(); }
+    T& operator*() const { return *get(); }
+    operator T*() const { return get(); }
+
+private:
+    void** m_slot;
+};
+
+// In the precise mode, the native stack between the stack pointer and
+// this object is scanned conservatively while the object is alive, so
+// native code called from the declaring function does not need handles.
+// The declaring function itself keeps its GC pointers in handles. Only
+// the outermost scope of the thread counts, as it covers the inner ones.
+class ConservativeStackScope {
+public:
+    ConservativeStackScope()
+        : m_prevBoundary(HandleScope::s_data.stackBoundary)
+    {
+        if (!m_prevBoundary) {
+            HandleScope::s_data.stackBoundary = this;
+        }
+    }
+
+    ~ConservativeStackScope()
+    {
+        HandleScope::s_data.stackBoundary = m_prevBoundary;
+    }
+
+private:
+    ConservativeStackScope(const ConservativeStackScope&) = delete;
+    ConservativeStackScope& operator=(const ConservativeStackScope&) = delete;
+
+    void* m_prevBoundary;
+};
+}
+
+#endif
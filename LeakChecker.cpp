@@ -5,33 +5,64 @@
 
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <algorithm>
+#include <cstring>
 
 namespace GCUtil {
 
 std::string HeapUsageVisualizer::m_outputFile = "bdwgcUsage.dat";
 
 size_t GCLeakChecker::m_totalFreed = 0;
+bool GCLeakChecker::m_logging = true;
 std::vector<GCLeakChecker::LeakCheckedAddr> GCLeakChecker::m_leakCheckedAddrs;
+std::unordered_map<uintptr_t, size_t> GCLeakChecker::m_allocatedAddrs;
+std::vector<std::string> GCLeakChecker::m_descriptions;
+std::unordered_map<std::string, uint32_t> GCLeakChecker::m_descriptionIndexes;
 static std::string s_gcLogPhaseName = "initial phase";
 
+static const char s_dumpMagic[4] = { 'G', 'C', 'L', 'K' };
+static const uint32_t s_dumpVersion = 1;
+
 void HeapUsageVisualizer::initialize()
 {
-    remove(HeapUsageVisualizer::m_outputFile.c_str());
-    FILE* fp = fopen(HeapUsageVisualizer::m_outputFile.c_str(), "a");
+    // Truncate rather than remove the file, since GC_dump_for_graph keeps
+    // it open.
+    FILE* fp = fopen(HeapUsageVisualizer::m_outputFile.c_str(), "w");
     if (fp) {
         fprintf(fp, "GC_no    PeakRSS   TotalHeap    Marked  # Phase\n");
         fclose(fp);
     }
 }
 
+void HeapUsageVisualizer::dump(const char* phase)
+{
+    GC_dump_for_graph(HeapUsageVisualizer::m_outputFile.c_str(), phase);
+}
+
+
+uint32_t GCLeakChecker::descriptionIndex(const std::string& description)
+{
+    auto it = m_descriptionIndexes.find(description);
+    if (it != m_descriptionIndexes.end()) {
+        return it->second;
+    }
+    uint32_t index = (uint32_t)m_descriptions.size();
+    m_descriptions.push_back(description);
+    m_descriptionIndexes[description] = index;
+    return index;
+}
 
 void GCLeakChecker::registerAddress(void* ptr, std::string description)
 {
     RELEASE_ASSERT(ptr);
-    m_leakCheckedAddrs.push_back(LeakCheckedAddr{ (void*)((size_t)ptr + 1), description, false });
+    uintptr_t key = (uintptr_t)ptr + 1;
+    m_allocatedAddrs[key] = m_leakCheckedAddrs.size();
+    m_leakCheckedAddrs.push_back(LeakCheckedAddr{ key, descriptionIndex(description), false });
 
-    printf("GCLeakChecker::registerAddress %p (%zu - %zu = %zu)\n", ptr,
-           m_leakCheckedAddrs.size(), m_totalFreed, m_leakCheckedAddrs.size() - m_totalFreed);
+    if (m_logging) {
+        printf("GCLeakChecker::registerAddress %p (%zu - %zu = %zu)\n", ptr,
+               m_leakCheckedAddrs.size(), m_totalFreed, m_leakCheckedAddrs.size() - m_totalFreed);
+    }
 
     GC_REGISTER_FINALIZER_NO_ORDER(ptr, [](void* obj, void* cd) {
         GCLeakChecker::unregisterAddress(obj);
@@ -44,16 +75,151 @@ void GCLeakChecker::unregisterAddress(void* ptr)
     RELEASE_ASSERT(ptr);
     m_totalFreed++;
 
-    printf("GCLeakChecker::unregisterAddress %p (%zu - %zu = %zu)\n", ptr,
-           m_leakCheckedAddrs.size(), m_totalFreed, m_leakCheckedAddrs.size() - m_totalFreed);
+    if (m_logging) {
+        printf("GCLeakChecker::unregisterAddress %p (%zu - %zu = %zu)\n", ptr,
+               m_leakCheckedAddrs.size(), m_totalFreed, m_leakCheckedAddrs.size() - m_totalFreed);
+    }
+
+    auto it = m_allocatedAddrs.find((uintptr_t)ptr + 1);
+    RELEASE_ASSERT(it != m_allocatedAddrs.end());
+    m_leakCheckedAddrs[it->second].deallocated = true;
+    m_allocatedAddrs.erase(it);
+}
 
-    for (auto& it : m_leakCheckedAddrs) {
-        if (it.ptr == (void*)((size_t)ptr + 1)) {
-            it.deallocated = true;
-            return;
+void GCLeakChecker::setLogging(bool enable)
+{
+    m_logging = enable;
+}
+
+struct LeakSummary {
+    const std::string* description;
+    size_t registered;
+    size_t deallocated;
+};
+
+template <typename Entries>
+static void printSummaryOf(const std::vector<std::string>& descriptions, const Entries& entries, FILE* out)
+{
+    std::vector<LeakSummary> summaries(descriptions.size());
+    for (size_t i = 0; i < descriptions.size(); i++) {
+        summaries[i] = LeakSummary{ &descriptions[i], 0, 0 };
+    }
+    size_t total = 0, totalDeallocated = 0;
+    for (const auto& it : entries) {
+        summaries[it.description].registered++;
+        total++;
+        if (it.deallocated) {
+            summaries[it.description].deallocated++;
+            totalDeallocated++;
         }
     }
-    RELEASE_ASSERT_NOT_REACHED();
+
+    // Most leaked descriptions first.
+    std::sort(summaries.begin(), summaries.end(), [](const LeakSummary& a, const LeakSummary& b) {
+        return a.registered - a.deallocated > b.registered - b.deallocated;
+    });
+
+    fprintf(out, "GCLeakChecker summary: %zu registered, %zu deallocated, %zu still allocated\n",
+            total, totalDeallocated, total - totalDeallocated);
+    fprintf(out, "%12s %12s %12s  %s\n", "Allocated", "Registered", "Deallocated", "Description");
+    for (const auto& it : summaries) {
+        fprintf(out, "%12zu %12zu %12zu  %s\n", it.registered - it.deallocated, it.registered,
+                it.deallocated, it.description->c_str());
+    }
+}
+
+void GCLeakChecker::printSummary(FILE* out)
+{
+    printSummaryOf(m_descriptions, m_leakCheckedAddrs, out);
+}
+
+// Dump format (native byte order):
+//   "GCLK", u32 version,
+//   u32 description count, { u32 length, bytes }...,
+//   u64 entry count, { u64 address, u32 description, u8 deallocated }...
+bool GCLeakChecker::dump(const char* fileName)
+{
+    FILE* fp = fopen(fileName, "wb");
+    if (!fp) {
+        return false;
+    }
+
+    fwrite(s_dumpMagic, sizeof(s_dumpMagic), 1, fp);
+    fwrite(&s_dumpVersion, sizeof(s_dumpVersion), 1, fp);
+
+    uint32_t descriptionCount = (uint32_t)m_descriptions.size();
+    fwrite(&descriptionCount, sizeof(descriptionCount), 1, fp);
+    for (const auto& it : m_descriptions) {
+        uint32_t length = (uint32_t)it.size();
+        fwrite(&length, sizeof(length), 1, fp);
+        fwrite(it.data(), 1, length, fp);
+    }
+
+    uint64_t entryCount = m_leakCheckedAddrs.size();
+    fwrite(&entryCount, sizeof(entryCount), 1, fp);
+    for (const auto& it : m_leakCheckedAddrs) {
+        uint64_t address = it.ptr - 1;
+        uint8_t deallocated = it.deallocated;
+        fwrite(&address, sizeof(address), 1, fp);
+        fwrite(&it.description, sizeof(it.description), 1, fp);
+        fwrite(&deallocated, sizeof(deallocated), 1, fp);
+    }
+
+    bool success = !ferror(fp);
+    fclose(fp);
+    return success;
+}
+
+bool GCLeakChecker::summarizeDump(const char* fileName, FILE* out)
+{
+    FILE* fp = fopen(fileName, "rb");
+    if (!fp) {
+        return false;
+    }
+
+    struct Entry {
+        uint32_t description;
+        bool deallocated;
+    };
+    std::vector<std::string> descriptions;
+    std::vector<Entry> entries;
+
+    char magic[sizeof(s_dumpMagic)];
+    uint32_t version, descriptionCount;
+    bool success = fread(magic, sizeof(magic), 1, fp) == 1 && !memcmp(magic, s_dumpMagic, sizeof(magic))
+        && fread(&version, sizeof(version), 1, fp) == 1 && version == s_dumpVersion
+        && fread(&descriptionCount, sizeof(descriptionCount), 1, fp) == 1;
+
+    for (uint32_t i = 0; success && i < descriptionCount; i++) {
+        uint32_t length;
+        success = fread(&length, sizeof(length), 1, fp) == 1;
+        if (success) {
+            std::string description(length, '\0');
+            success = !length || fread(&description[0], 1, length, fp) == length;
+            descriptions.push_back(std::move(description));
+        }
+    }
+
+    uint64_t entryCount = 0;
+    success = success && fread(&entryCount, sizeof(entryCount), 1, fp) == 1;
+    for (uint64_t i = 0; success && i < entryCount; i++) {
+        uint64_t address;
+        uint32_t description;
+        uint8_t deallocated;
+        success = fread(&address, sizeof(address), 1, fp) == 1
+            && fread(&description, sizeof(description), 1, fp) == 1
+            && fread(&deallocated, sizeof(deallocated), 1, fp) == 1
+            && description < descriptionCount;
+        entries.push_back(Entry{ description, !!deallocated });
+    }
+    fclose(fp);
+
+    if (!success) {
+        fprintf(out, "GCLeakChecker: %s is not a valid dump\n", fileName);
+        return false;
+    }
+    printSummaryOf(descriptions, entries, out);
+    return true;
 }
 
 void GCLeakChecker::dumpBackTrace(const char* phase)
@@ -66,10 +232,11 @@ void GCLeakChecker::dumpBackTrace(const char* phase)
     fprintf(stderr, "GCLeakChecker::dumpBackTrace %s start >>>>>>>>>>\n", s_gcLogPhaseName.c_str());
     GC_gcollect();
     for (const auto& it : m_leakCheckedAddrs) {
+        const char* description = m_descriptions[it.description].c_str();
         if (it.deallocated) {
-            fprintf(stderr, "%s (%p) deallocated\n", it.description.c_str(), (void*)((size_t)it.ptr - 1));
+            fprintf(stderr, "%s (%p) deallocated\n", description, (void*)((size_t)it.ptr - 1));
         } else {
-            fprintf(stderr, "Backtrace of %s (%p):\n", it.description.c_str(), (void*)((size_t)it.ptr - 1));
+            fprintf(stderr, "Backtrace of %s (%p):\n", description, (void*)((size_t)it.ptr - 1));
             GC_print_backtrace((void*)((size_t)it.ptr - 1));
         }
     }
@@ -79,10 +246,11 @@ void GCLeakChecker::dumpBackTrace(const char* phase)
     fprintf(stderr, "Please re-configure bdwgc with `--enable-gc-debug`, ");
     fprintf(stderr, "and re-build escargot with `-DGC_DEBUG`.\n");
     for (const auto& it : m_leakCheckedAddrs) {
+        const char* description = m_descriptions[it.description].c_str();
         if (it.deallocated) {
-            fprintf(stderr, "%s (%p) deallocated\n", it.description.c_str(), (void*)((size_t)it.ptr - 1));
+            fprintf(stderr, "%s (%p) deallocated\n", description, (void*)((size_t)it.ptr - 1));
         } else {
-            fprintf(stderr, "%s (%p) still allocated\n", it.description.c_str(), (void*)((size_t)it.ptr - 1));
+            fprintf(stderr, "%s (%p) still allocated\n", description, (void*)((size_t)it.ptr - 1));
         }
     }
 #endif
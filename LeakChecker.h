@@ -4,7 +4,10 @@
 #ifdef PROFILE_BDWGC
 
 #include "GCUtil.h"
+#include <cstdint>
+#include <cstdio>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace GCUtil {
@@ -12,6 +15,8 @@ namespace GCUtil {
 class HeapUsageVisualizer {
 public:
     static void initialize();
+    // Appends the heap occupancy of the last collection to the output file.
+    static void dump(const char* phase);
 
 private:
     static std::string m_outputFile;
@@ -23,16 +28,34 @@ public:
     static void dumpBackTrace(const char* phase = NULL);
     static void setGCPhaseName(std::string name);
 
+    // Prints every register and unregister call (on by default).
+    static void setLogging(bool enable);
+
+    // Prints the number of registered, deallocated and still allocated
+    // addresses per description.
+    static void printSummary(FILE* out = stderr);
+
+    // Writes the tracked addresses in a compact binary format, which can
+    // be summarized later with summarizeDump.
+    static bool dump(const char* fileName);
+    static bool summarizeDump(const char* fileName, FILE* out = stderr);
+
 private:
     static void unregisterAddress(void* ptr);
+    static uint32_t descriptionIndex(const std::string& description);
 
     struct LeakCheckedAddr {
-        void* ptr;
-        std::string description;
+        uintptr_t ptr; // address + 1, so the collector does not see it
+        uint32_t description;
         bool deallocated;
     };
     static size_t m_totalFreed;
+    static bool m_logging;
     static std::vector<LeakCheckedAddr> m_leakCheckedAddrs;
+    // Index of the still allocated entry of each address.
+    static std::unordered_map<uintptr_t, size_t> m_allocatedAddrs;
+    static std::vector<std::string> m_descriptions;
+    static std::unordered_map<std::string, uint32_t> m_descriptionIndexes;
 };
 }
 
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+#ifndef __GCUtilTypedAllocation__
+#define __GCUtilTypedAllocation__
+
+#include "GCUtil.h"
+#include "GCUtilInternal.h"
+#include <gc_inline.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <utility>
+
+namespace GCUtil {
+
+template <size_t... Indexes>
+struct gc_index_sequence {
+};
+
+template <size_t N, size_t... Indexes>
+struct gc_make_index_sequence : gc_make_index_sequence<N - 1, N - 1, Indexes...> {
+};
+
+template <size_t... Indexes>
+struct gc_make_index_sequence<0, Indexes...> {
+    typedef gc_index_sequence<Indexes...> type;
+};
+
+// Word `index` of the GC_make_descriptor bitmap which has a bit set for
+// every pointer member at the given byte offsets.
+constexpr GC_word gc_bitmap_word(size_t)
+{
+    return 0;
+}
+
+template <typename... Offsets>
+constexpr GC_word gc_bitmap_word(size_t index, size_t offset, Offsets... offsets)
+{
+    return ((offset / sizeof(GC_word)) / GC_WORDSZ == index ? (GC_word)1 << ((offset / sizeof(GC_word)) % GC_WORDSZ) : 0)
+        | gc_bitmap_word(index, offsets...);
+}
+
+constexpr bool gc_pointer_offsets_valid(size_t, size_t)
+{
+    return true;
+}
+
+template <typename... Offsets>
+constexpr bool gc_pointer_offsets_valid(size_t size, size_t minOffset, size_t offset, Offsets... offsets)
+{
+    return offset % sizeof(GC_word) == 0 && offset >= minOffset && offset + sizeof(GC_word) <= size
+        && gc_pointer_offsets_valid(size, offset + sizeof(GC_word), offsets...);
+}
+
+// Allocates objects of type T whose only GC pointers are stored at the
+// given byte offsets (use offsetof), e.g.
+//
+//   typedef TypedAllocation<Node, offsetof(Node, m_next), offsetof(Node, m_value)> NodeAllocation;
+//   Node* node = NodeAllocation::create(...);
+//
+// The descriptor bitmap is built at compile time and turned into a
+// GC_descr on the first allocation of each heap, so the collector only
+// scans the listed words. Types without pointers are allocated with
+// GC_MALLOC_ATOMIC and types consisting only of pointers with GC_MALLOC,
+// which need no descriptor at all. Only the descriptor lookup is inline
+// for the other types: GC_MALLOC_EXPLICITLY_TYPED stays a call into
+// bdwgc (wrapped by the hooks of GCUtil.h), which stores the descriptor
+// in the last word of the object.
+template <typename T, size_t... PointerOffsets>
+class TypedAllocation {
+public:
+    static const size_t wordCount = GC_WORD_LEN(T);
+    static const size_t pointerCount = sizeof...(PointerOffsets);
+
+    static_assert(sizeof(T) % sizeof(GC_word) == 0, "The size of the type should be a multiple of the word size");
+    static_assert(gc_pointer_offsets_valid(sizeof(T), 0, PointerOffsets...), "Pointer offsets should be ascending, word aligned and inside the type");
+
+    static GC_descr descriptor()
+    {
+        if (GC_EXPECT(!s_descriptor, 0)) {
+            s_descriptor = makeDescriptor();
+        }
+        return s_descriptor;
+    }
+
+    // Returns uninitialized storage for one T.
+    static void* allocate()
+    {
+        void* ptr;
+        if (!pointerCount) {
+            ptr = GC_MALLOC_ATOMIC(sizeof(T));
+        } else if (pointerCount == wordCount) {
+            ptr = GC_MALLOC(sizeof(T));
+        } else {
+            ptr = GC_MALLOC_EXPLICITLY_TYPED(sizeof(T), descriptor());
+        }
+        RELEASE_ASSERT(ptr);
+        return ptr;
+    }
+
+    template <typename... Args>
+    static T* create(Args&&... args)
+    {
+        return new (allocate()) T(std::forward<Args>(args)...);
+    }
+
+private:
+    static GC_descr makeDescriptor()
+    {
+        return makeDescriptor(typename gc_make_index_sequence<(wordCount + GC_WORDSZ - 1) / GC_WORDSZ>::type());
+    }
+
+    template <size_t... Indexes>
+    static GC_descr makeDescriptor(gc_index_sequence<Indexes...>)
+    {
+        GC_word bitmap[] = { gc_bitmap_word(Indexes, PointerOffsets...)... };
+        return GC_make_descriptor(bitmap, wordCount);
+    }
+
+    // Descriptors of large bitmaps are registered in the heap, so they
+    // are cached per heap.
+    static MAY_THREAD_LOCAL GC_descr s_descriptor;
+};
+
+template <typename T, size_t... PointerOffsets>
+MAY_THREAD_LOCAL GC_descr TypedAllocation<T, PointerOffsets...>::s_descriptor = 0;
+}
+
+#endif
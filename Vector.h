@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+#ifndef __GCUtilVector__
+#define __GCUtilVector__
+
+#include "GCUtil.h"
+
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace GCUtil {
+
+// Element types which never hold GC pointers. Vectors of these types
+// allocate their storage with GC_MALLOC_ATOMIC, so the collector does
+// not scan them. Specialize it for other pointer-free types.
+template <typename T>
+struct gc_is_pointer_free
+    : std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_enum<T>::value> {
+};
+
+template <typename T, size_t InlineCapacity>
+struct VectorInlineStorage {
+    T* buffer() { return reinterpret_cast<T*>(m_storage); }
+    alignas(T) char m_storage[sizeof(T) * InlineCapacity];
+};
+
+template <typename T>
+struct VectorInlineStorage<T, 0> {
+    T* buffer() { return nullptr; }
+};
+
+// Contiguous container for the GC heap.
+//
+// Unlike std::vector, only the begin pointer is stored; the size and the
+// capacity are plain integers. So the object never holds a pointer past
+// the end of its buffer, which the collector would see as a reference to
+// the next heap object (see README.md).
+//
+// Storage is allocated with the kind matching the element type, grows
+// in place into the granule slack or with GC_REALLOC when the elements
+// can be moved with memcpy, and the first InlineCapacity elements live
+// inside the vector object itself.
+template <typename T, size_t InlineCapacity = 0>
+class Vector {
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    Vector()
+        : m_size(0)
+        , m_capacity(InlineCapacity)
+    {
+        m_buffer = m_inline.buffer();
+    }
+
+    explicit Vector(size_t size)
+        : Vector()
+    {
+        resize(size);
+    }
+
+    Vector(size_t size, const T& value)
+        : Vector()
+    {
+        resize(size, value);
+    }
+
+    Vector(std::initializer_list<T> list)
+        : Vector()
+    {
+        reserve(list.size());
+        for (const T& value : list) {
+            new (m_buffer + m_size++) T(value);
+        }
+    }
+
+    Vector(const Vector& other)
+        : Vector()
+    {
+        reserve(other.m_size);
+        for (size_t i = 0; i < other.m_size; i++) {
+            new (m_buffer + i) T(other.m_buffer[i]);
+        }
+        m_size = other.m_size;
+    }
+
+    Vector(Vector&& other)
+        : Vector()
+    {
+        takeFrom(std::move(other));
+    }
+
+    ~Vector()
+    {
+        destroyElements(0, m_size);
+        releaseBuffer();
+    }
+
+    Vector& operator=(const Vector& other)
+    {
+        if (this != &other) {
+            clear();
+            reserve(other.m_size);
+            for (size_t i = 0; i < other.m_size; i++) {
+                new (m_buffer + i) T(other.m_buffer[i]);
+            }
+            m_size = other.m_size;
+        }
+        return *this;
+    }
+
+    Vector& operator=(Vector&& other)
+    {
+        if (this != &other) {
+            clear();
+            releaseBuffer();
+            m_buffer = m_inline.buffer();
+            m_capacity = InlineCapacity;
+            takeFrom(std::move(other));
+        }
+        return *this;
+    }
+
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    bool empty() const { return !m_size; }
+
+    T* data() { return m_buffer; }
+    const T* data() const { return m_buffer; }
+
+    iterator begin() { return m_buffer; }
+    iterator end() { return m_buffer + m_size; }
+    const_iterator begin() const { return m_buffer; }
+    const_iterator end() const { return m_buffer + m_size; }
+
+    T& operator[](size_t idx)
+    {
+        assert(idx < m_size);
+        return m_buffer[idx];
+    }
+
+    const T& operator[](size_t idx) const
+    {
+        assert(idx < m_size);
+        return m_buffer[idx];
+    }
+
+    T& front() { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T& back() { return (*this)[m_size - 1]; }
+    const T& back() const { return (*this)[m_size - 1]; }
+
+    void push_back(const T& value)
+    {
+        if (m_size == m_capacity) {
+            // value may live in the current buffer.
+            T copy(value);
+            grow(m_size + 1);
+            new (m_buffer + m_size) T(std::move(copy));
+        } else {
+            new (m_buffer + m_size) T(value);
+        }
+        m_size++;
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (m_size == m_capacity) {
+            T value(std::forward<Args>(args)...);
+            grow(m_size + 1);
+            new (m_buffer + m_size) T(std::move(value));
+        } else {
+            new (m_buffer + m_size) T(std::forward<Args>(args)...);
+        }
+        return m_buffer[m_size++];
+    }
+
+    void pop_back()
+    {
+        assert(m_size);
+        destroyElements(m_size - 1, m_size);
+        m_size--;
+    }
+
+    iterator insert(const_iterator position, const T& value)
+    {
+        size_t idx = position - m_buffer;
+        assert(idx <= m_size);
+        T copy(value);
+        if (m_size == m_capacity) {
+            grow(m_size + 1);
+        }
+        if (idx == m_size) {
+            new (m_buffer + m_size) T(std::move(copy));
+        } else {
+            new (m_buffer + m_size) T(std::move(m_buffer[m_size - 1]));
+            for (size_t i = m_size - 1; i > idx; i--) {
+                m_buffer[i] = std::move(m_buffer[i - 1]);
+            }
+            m_buffer[idx] = std::move(copy);
+        }
+        m_size++;
+        return m_buffer + idx;
+    }
+
+    iterator erase(const_iterator position)
+    {
+        return erase(position, position + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_t start = first - m_buffer;
+        size_t count = last - first;
+        assert(start + count <= m_size);
+        if (count) {
+            for (size_t i = start; i + count < m_size; i++) {
+                m_buffer[i] = std::move(m_buffer[i + count]);
+            }
+            destroyElements(m_size - count, m_size);
+            m_size -= count;
+        }
+        return m_buffer + start;
+    }
+
+    void resize(size_t newSize)
+    {
+        if (newSize > m_size) {
+            reserve(newSize);
+            for (size_t i = m_size; i < newSize; i++) {
+                new (m_buffer + i) T();
+            }
+        } else {
+            destroyElements(newSize, m_size);
+        }
+        m_size = newSize;
+    }
+
+    void resize(size_t newSize, const T& value)
+    {
+        if (newSize > m_size) {
+            T copy(value);
+            reserve(newSize);
+            for (size_t i = m_size; i < newSize; i++) {
+                new (m_buffer + i) T(copy);
+            }
+        } else {
+            destroyElements(newSize, m_size);
+        }
+        m_size = newSize;
+    }
+
+    void reserve(size_t newCapacity)
+    {
+        if (newCapacity > m_capacity) {
+            reallocate(newCapacity);
+        }
+    }
+
+    void clear()
+    {
+        destroyElements(0, m_size);
+        m_size = 0;
+    }
+
+    void shrink_to_fit()
+    {
+        if (m_buffer == m_inline.buffer() || m_size == m_capacity) {
+            return;
+        }
+
+        T* oldBuffer = m_buffer;
+        size_t oldCapacity = m_capacity;
+        if (m_size <= InlineCapacity) {
+            m_buffer = m_inline.buffer();
+            m_capacity = InlineCapacity;
+        } else {
+            m_buffer = allocate(m_size, m_capacity);
+        }
+        moveElements(oldBuffer, m_buffer, m_size);
+        freeBuffer(oldBuffer, oldCapacity);
+    }
+
+private:
+    static const bool s_pointerFree = gc_is_pointer_free<T>::value;
+    static const bool s_relocatable = std::is_trivially_copyable<T>::value;
+
+    static T* allocate(size_t count, size_t& capacity)
+    {
+        size_t bytes = sizeof(T) * count;
+        void* buffer = s_pointerFree ? GC_MALLOC_ATOMIC(bytes) : GC_MALLOC(bytes);
+        RELEASE_ASSERT(buffer);
+        capacity = gc_usable_count<T>(buffer, count);
+        return static_cast<T*>(buffer);
+    }
+
+    // capacity comes from gc_usable_count, so the size passed is at most
+    // GC_size(buffer); GC_free_sized takes the size class from the header.
+    static void freeBuffer(T* buffer, size_t capacity)
+    {
+        GC_FREE_SIZED(buffer, sizeof(T) * capacity, s_pointerFree ? GC_I_PTRFREE : GC_I_NORMAL);
+    }
+
+    static void moveElements(T* from, T* to, size_t count)
+    {
+        if (s_relocatable) {
+            memcpy((void*)to, (void*)from, sizeof(T) * count);
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                new (to + i) T(std::move(from[i]));
+                from[i].~T();
+            }
+        }
+    }
+
+    void destroyElements(size_t from, size_t to)
+    {
+        for (size_t i = from; i < to; i++) {
+            m_buffer[i].~T();
+        }
+        // Clear the vacated slots, so they do not keep dead objects alive.
+        if (!s_pointerFree && from < to) {
+            memset((void*)(m_buffer + from), 0, sizeof(T) * (to - from));
+        }
+    }
+
+    void releaseBuffer()
+    {
+        if (m_buffer != m_inline.buffer()) {
+            freeBuffer(m_buffer, m_capacity);
+        }
+    }
+
+    void grow(size_t minCapacity)
+    {
+        size_t newCapacity = m_capacity * 2;
+        if (newCapacity < minCapacity) {
+            newCapacity = minCapacity;
+        }
+        if (newCapacity < 4) {
+            newCapacity = 4;
+        }
+        reallocate(newCapacity);
+    }
+
+    void reallocate(size_t newCapacity)
+    {
+        if (m_buffer != m_inline.buffer() && s_relocatable) {
+            // GC_REALLOC keeps the object in place when it still fits
+            // into its block, and keeps the kind of the object.
+            void* buffer = GC_REALLOC(m_buffer, sizeof(T) * newCapacity);
+            RELEASE_ASSERT(buffer);
+            m_buffer = static_cast<T*>(buffer);
+            m_capacity = gc_usable_count<T>(buffer, newCapacity);
+            return;
+        }
+
+        T* oldBuffer = m_buffer;
+        size_t oldCapacity = m_capacity;
+        m_buffer = allocate(newCapacity, m_capacity);
+        if (!oldBuffer) {
+            // Empty vector without inline storage.
+            return;
+        }
+        moveElements(oldBuffer, m_buffer, m_size);
+        if (oldBuffer != m_inline.buffer()) {
+            freeBuffer(oldBuffer, oldCapacity);
+        }
+    }
+
+    void takeFrom(Vector&& other)
+    {
+        if (other.m_buffer == other.m_inline.buffer()) {
+            reserve(other.m_size);
+            moveElements(other.m_buffer, m_buffer, other.m_size);
+        } else {
+            m_buffer = other.m_buffer;
+            m_capacity = other.m_capacity;
+            other.m_buffer = other.m_inline.buffer();
+            other.m_capacity = InlineCapacity;
+        }
+        m_size = other.m_size;
+        other.m_size = 0;
+    }
+
+    T* m_buffer;
+    size_t m_size;
+    size_t m_capacity;
+    VectorInlineStorage<T, InlineCapacity> m_inline;
+};
+
+// Vector keeping up to InlineCapacity elements inside the object.
+template <typename T, size_t InlineCapacity>
+using SmallVector = Vector<T, InlineCapacity>;
+}
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+#include "GCUtilInternal.h"
+#include "WeakMap.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace GCUtil {
+
+// The registry is allocated with malloc, so it does not keep the tables
+// alive.
+struct WeakTableRegistry {
+    std::vector<WeakTableBase*> tables;
+    GC_before_sweep_proc prevBeforeSweep;
+
+    static void GC_CALLBACK removeDeadEntries();
+};
+
+static MAY_THREAD_LOCAL WeakTableRegistry* s_weakTableRegistry = nullptr;
+
+void GC_CALLBACK WeakTableRegistry::removeDeadEntries()
+{
+    WeakTableRegistry* registry = s_weakTableRegistry;
+    auto& tables = registry->tables;
+    for (size_t i = 0; i < tables.size();) {
+        WeakTableBase* table = tables[i];
+        void* base = GC_base(table);
+        if (base && !GC_is_marked(base)) {
+            // The table itself is garbage; so are its buffers.
+            tables[i] = tables.back();
+            tables.pop_back();
+            continue;
+        }
+        table->removeDeadEntries();
+        i++;
+    }
+
+    if (registry->prevBeforeSweep) {
+        registry->prevBeforeSweep();
+    }
+}
+
+WeakTableBase::WeakTableBase()
+{
+    if (!s_weakTableRegistry) {
+        s_weakTableRegistry = new WeakTableRegistry();
+        s_weakTableRegistry->prevBeforeSweep = GC_get_before_sweep_callback();
+        GC_set_before_sweep_callback(WeakTableRegistry::removeDeadEntries);
+    }
+    s_weakTableRegistry->tables.push_back(this);
+}
+
+WeakTableBase::~WeakTableBase()
+{
+    // A table in the GC heap might have been dropped already.
+    auto& tables = s_weakTableRegistry->tables;
+    auto it = std::find(tables.begin(), tables.end(), this);
+    if (it != tables.end()) {
+        *it = tables.back();
+        tables.pop_back();
+    }
+}
+
+bool WeakTableBase::isMarked(const void* ptr)
+{
+#if defined(GC_DEBUG)
+    // Pointers returned by the debug allocator follow the debug header.
+    ptr = GC_base(const_cast<void*>(ptr));
+#endif
+    return GC_is_marked(ptr);
+}
+}
@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+#ifndef __GCUtilWeakMap__
+#define __GCUtilWeakMap__
+
+#include "GCUtil.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+
+namespace GCUtil {
+
+// Every live weak table is registered per heap. After marking (and after
+// finalization has resurrected what it needs), the collector calls
+// removeDeadEntries of every table, so entries whose weak object is about
+// to be reclaimed are cleared in bulk, without a disappearing link per
+// entry. A table which lives in the GC heap and becomes unreachable
+// itself is dropped from the registry without being destroyed.
+class WeakTableBase {
+public:
+    WeakTableBase();
+    virtual ~WeakTableBase();
+
+protected:
+    // Called with the allocation lock held. It must not allocate.
+    virtual void removeDeadEntries() = 0;
+
+    // Whether the object is still alive after the current collection.
+    // Only valid inside removeDeadEntries.
+    static bool isMarked(const void* ptr);
+
+    friend struct WeakTableRegistry;
+
+private:
+    WeakTableBase(const WeakTableBase&) = delete;
+    WeakTableBase& operator=(const WeakTableBase&) = delete;
+};
+
+// Objects do not move, so pointers are hashed by address.
+template <typename T>
+struct WeakPointerHash {
+    size_t operator()(T ptr) const
+    {
+        uint64_t hash = (uint64_t)(uintptr_t)ptr;
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        return (size_t)hash;
+    }
+};
+
+struct WeakNoValue {
+};
+
+// Open-addressing hash table with linear probing, where either the keys
+// or the values are weak pointers to GC objects (the base pointer of the
+// object, as returned by the allocator).
+//
+// The weak side is kept in an atomic array, so the collector does not see
+// it, and a null weak pointer marks an empty slot. Entries are deleted
+// with backward shifting, so the table never contains tombstones; after
+// the dead entries are cleared by a collection, the remaining ones are
+// moved back toward their home slots in place.
+//
+// Keys and values are copied with memcpy and should be trivially
+// copyable. Objects which are only reachable from their own entry are
+// kept alive if the strong side refers to them (there are no ephemerons).
+template <typename Key, typename Value, bool WeakKeys,
+          typename Hash, typename Equal = std::equal_to<Key>>
+class WeakHashTable : public WeakTableBase {
+public:
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                  "Keys and values of weak tables should be trivially copyable");
+    static_assert(std::is_pointer<typename std::conditional<WeakKeys, Key, Value>::type>::value,
+                  "The weak side of the table should be a pointer");
+
+    WeakHashTable()
+        : m_keys(nullptr)
+        , m_values(nullptr)
+        , m_capacity(0)
+        , m_size(0)
+    {
+    }
+
+    ~WeakHashTable()
+    {
+        releaseBuffers();
+    }
+
+    // The number of entries, including the ones whose weak object is
+    // already unreachable but not collected yet.
+    size_t size() const { return m_size; }
+    bool empty() const { return !m_size; }
+
+    void clear()
+    {
+        releaseBuffers();
+        m_keys = nullptr;
+        m_values = nullptr;
+        m_capacity = m_size = 0;
+    }
+
+    // Calls fn(key, value) for every entry. The table must not be
+    // modified during the iteration.
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        for (size_t i = 0; i < m_capacity; i++) {
+            if (!isEmpty(i)) {
+                fn(m_keys[i], valueAt(i));
+            }
+        }
+    }
+
+protected:
+    static const bool s_hasValues = !std::is_empty<Value>::value;
+    static const size_t s_minCapacity = 8;
+
+    size_t lookup(const Key& key) const
+    {
+        if (!m_capacity) {
+            return notFound();
+        }
+        size_t mask = m_capacity - 1;
+        for (size_t i = Hash()(key) & mask;; i = (i + 1) & mask) {
+            if (isEmpty(i)) {
+                return notFound();
+            }
+            if (Equal()(m_keys[i], key)) {
+                return i;
+            }
+        }
+    }
+
+    static size_t notFound() { return SIZE_MAX; }
+
+    // Returns the slot of key, which is new if it was not in the table.
+    size_t add(const Key& key, const Value& value, bool& isNew)
+    {
+        if ((m_size + 1) * 4 > m_capacity * 3) {
+            rehash(m_capacity ? m_capacity * 2 : s_minCapacity);
+        } else if (m_capacity > s_minCapacity && m_size * 8 < m_capacity) {
+            // Shrink the table after many entries were collected.
+            rehash(m_capacity / 2);
+        }
+
+        size_t mask = m_capacity - 1;
+        size_t i = Hash()(key) & mask;
+        for (; !isEmpty(i); i = (i + 1) & mask) {
+            if (Equal()(m_keys[i], key)) {
+                isNew = false;
+                return i;
+            }
+        }
+
+        isNew = true;
+        m_keys[i] = key;
+        if (s_hasValues) {
+            m_values[i] = value;
+        }
+        assert(!isEmpty(i));
+        m_size++;
+        return i;
+    }
+
+    bool removeAt(size_t i)
+    {
+        if (i == notFound()) {
+            return false;
+        }
+        clearSlot(i);
+        m_size--;
+
+        // Backward shift deletion: move the following entries of the
+        // cluster into the hole unless it is before their home slot.
+        size_t mask = m_capacity - 1;
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask; !isEmpty(j); j = (j + 1) & mask) {
+            size_t home = Hash()(m_keys[j]) & mask;
+            if (((j - home) & mask) >= ((j - hole) & mask)) {
+                moveSlot(j, hole);
+                hole = j;
+            }
+        }
+        return true;
+    }
+
+    Value& valueAt(size_t i) { return s_hasValues ? m_values[i] : noValue(); }
+    const Value& valueAt(size_t i) const { return s_hasValues ? m_values[i] : noValue(); }
+
+    virtual void removeDeadEntries() override
+    {
+        if (!m_size) {
+            return;
+        }
+
+        // Walk the table once from a slot which is empty before anything
+        // is cleared, so every cluster is visited from its beginning:
+        // dead entries are cleared, and the live ones are moved back to
+        // the first free slot after their home. The slots between the
+        // home and the new slot of an entry precede it in the walk, so
+        // they are not cleared later.
+        size_t mask = m_capacity - 1;
+        size_t start = 0;
+        while (!isEmpty(start)) {
+            start++;
+        }
+        for (size_t n = 1; n < m_capacity; n++) {
+            size_t i = (start + n) & mask;
+            if (isEmpty(i)) {
+                continue;
+            }
+            if (!isMarked(weakPointer(i))) {
+                clearSlot(i);
+                m_size--;
+                continue;
+            }
+            size_t j = Hash()(m_keys[i]) & mask;
+            while (j != i && !isEmpty(j)) {
+                j = (j + 1) & mask;
+            }
+            if (j != i) {
+                moveSlot(i, j);
+            }
+        }
+    }
+
+private:
+    static Value& noValue()
+    {
+        static Value value;
+        return value;
+    }
+
+    static const void* weakPointer(const Key* keys, const Value*, size_t i, std::true_type) { return (const void*)keys[i]; }
+    static const void* weakPointer(const Key*, const Value* values, size_t i, std::false_type) { return (const void*)values[i]; }
+
+    const void* weakPointer(size_t i) const
+    {
+        return weakPointer(m_keys, m_values, i, std::integral_constant<bool, WeakKeys>());
+    }
+
+    bool isEmpty(size_t i) const { return !weakPointer(i); }
+
+    void clearSlot(size_t i)
+    {
+        // Also clear the strong side, so it does not retain anything.
+        memset((void*)(m_keys + i), 0, sizeof(Key));
+        if (s_hasValues) {
+            memset((void*)(m_values + i), 0, sizeof(Value));
+        }
+    }
+
+    void moveSlot(size_t from, size_t to)
+    {
+        memcpy((void*)(m_keys + to), (void*)(m_keys + from), sizeof(Key));
+        if (s_hasValues) {
+            memcpy((void*)(m_values + to), (void*)(m_values + from), sizeof(Value));
+        }
+        clearSlot(from);
+    }
+
+    static void* allocateArray(size_t bytes, bool weak)
+    {
+        void* buffer = weak ? GC_MALLOC_ATOMIC(bytes) : GC_MALLOC(bytes);
+        RELEASE_ASSERT(buffer);
+        if (weak) {
+            // Atomic objects are not cleared by the allocator.
+            memset(buffer, 0, bytes);
+        }
+        return buffer;
+    }
+
+    void rehash(size_t newCapacity)
+    {
+        // The allocation may collect, which removes dead entries from the
+        // old buffers, so the table must stay consistent until both new
+        // buffers are there.
+        Key* newKeys = (Key*)allocateArray(sizeof(Key) * newCapacity, WeakKeys);
+        Value* newValues = s_hasValues ? (Value*)allocateArray(sizeof(Value) * newCapacity, !WeakKeys) : nullptr;
+
+        Key* oldKeys = m_keys;
+        Value* oldValues = m_values;
+        size_t oldCapacity = m_capacity;
+        m_keys = newKeys;
+        m_values = newValues;
+        m_capacity = newCapacity;
+
+        size_t mask = newCapacity - 1;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (!weakPointer(oldKeys, oldValues, i, std::integral_constant<bool, WeakKeys>())) {
+                continue;
+            }
+            size_t j = Hash()(oldKeys[i]) & mask;
+            while (!isEmpty(j)) {
+                j = (j + 1) & mask;
+            }
+            memcpy((void*)(m_keys + j), (void*)(oldKeys + i), sizeof(Key));
+            if (s_hasValues) {
+                memcpy((void*)(m_values + j), (void*)(oldValues + i), sizeof(Value));
+            }
+        }
+
+        if (oldCapacity) {
+            GC_FREE(oldKeys);
+            if (s_hasValues) {
+                GC_FREE(oldValues);
+            }
+        }
+    }
+
+    void releaseBuffers()
+    {
+        if (m_capacity) {
+            GC_FREE(m_keys);
+            if (s_hasValues) {
+                GC_FREE(m_values);
+            }
+        }
+    }
+
+    Key* m_keys;
+    Value* m_values;
+    size_t m_capacity; // zero or a power of two
+    size_t m_size;
+};
+
+// Map whose keys are held weakly: an entry is removed when its key is
+// collected. The values are held strongly.
+template <typename Key, typename Value, typename Hash = WeakPointerHash<Key>>
+class WeakMap : public WeakHashTable<Key, Value, true, Hash> {
+    typedef WeakHashTable<Key, Value, true, Hash> Base;
+
+public:
+    Value* find(Key key)
+    {
+        size_t i = Base::lookup(key);
+        return i == Base::notFound() ? nullptr : &Base::valueAt(i);
+    }
+
+    bool contains(Key key) const { return Base::lookup(key) != Base::notFound(); }
+
+    // Inserts the entry or replaces the value of an existing one.
+    void set(Key key, const Value& value)
+    {
+        assert(key);
+        bool isNew;
+        size_t i = Base::add(key, value, isNew);
+        Base::valueAt(i) = value;
+    }
+
+    bool remove(Key key) { return Base::removeAt(Base::lookup(key)); }
+};
+
+// Map whose values are held weakly: an entry is removed when its value is
+// collected. The keys are held strongly.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class WeakValueMap : public WeakHashTable<Key, Value, false, Hash> {
+    typedef WeakHashTable<Key, Value, false, Hash> Base;
+
+public:
+    // Returns null if there is no entry for key.
+    Value get(const Key& key) const
+    {
+        size_t i = Base::lookup(key);
+        return i == Base::notFound() ? nullptr : Base::valueAt(i);
+    }
+
+    bool contains(const Key& key) const { return Base::lookup(key) != Base::notFound(); }
+
+    void set(const Key& key, Value value)
+    {
+        assert(value);
+        bool isNew;
+        size_t i = Base::add(key, value, isNew);
+        Base::valueAt(i) = value;
+    }
+
+    bool remove(const Key& key) { return Base::removeAt(Base::lookup(key)); }
+};
+
+// Set of weakly held GC objects.
+template <typename T, typename Hash = WeakPointerHash<T>>
+class WeakSet : public WeakHashTable<T, WeakNoValue, true, Hash> {
+    typedef WeakHashTable<T, WeakNoValue, true, Hash> Base;
+
+public:
+    // Returns false if ptr was already in the set.
+    bool add(T ptr)
+    {
+        assert(ptr);
+        bool isNew;
+        Base::add(ptr, WeakNoValue(), isNew);
+        return isNew;
+    }
+
+    bool contains(T ptr) const { return Base::lookup(ptr) != Base::notFound(); }
+    bool remove(T ptr) { return Base::removeAt(Base::lookup(ptr)); }
+
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        Base::forEach([&fn](T ptr, const WeakNoValue&) { fn(ptr); });
+    }
+};
+}
+
+#endif
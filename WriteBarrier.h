@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+#ifndef __GCUtilWriteBarrier__
+#define __GCUtilWriteBarrier__
+
+#include "GCUtil.h"
+
+#include <cstddef>
+
+namespace GCUtil {
+
+// Card-marking write barrier for the incremental collection in the
+// manual VDB mode (GC_set_manual_vdb_allowed(1) before
+// GC_enable_incremental()). Every store of a GC pointer into the heap
+// must be followed by writeBarrier on the stored slot; it is a single
+// byte store to GC_card_table (see gc.h), which the collector turns into
+// dirty pages when it starts and finishes a minor collection. Without
+// the manual VDB mode the marks are ignored, so the barrier can be left
+// in place unconditionally.
+inline void writeBarrier(const void* slot)
+{
+    GC_card_table[GC_CARD_INDEX(slot)] = 1;
+}
+
+// Marks all the cards of [start, start + size), e.g. after copying
+// several pointers at once.
+inline void writeBarrierRange(const void* start, size_t size)
+{
+    if (!size) {
+        return;
+    }
+    GC_word card = (GC_word)start >> GC_LOG_CARD_BYTES;
+    GC_word last = ((GC_word)start + size - 1) >> GC_LOG_CARD_BYTES;
+    unsigned char* table = GC_card_table;
+    for (; card <= last; card++) {
+        table[card & (GC_CARD_TABLE_ENTRIES - 1)] = 1;
+    }
+}
+
+template <typename T, typename U>
+inline void storePointer(T*& slot, U* value)
+{
+    slot = value;
+    writeBarrier(&slot);
+}
+}
+
+#endif
@@ -243,6 +243,9 @@ static GC_bool setup_header(hdr * hhdr, struct hblk *block, size_t byte_sz,
       hhdr -> hb_sz = byte_sz;
       hhdr -> hb_obj_kind = (unsigned char)kind;
       hhdr -> hb_flags = (unsigned char)flags;
+#     ifdef BACKGROUND_SWEEP
+        hhdr -> hb_sweep_state = SWEEP_NONE;
+#     endif
       hhdr -> hb_block = block;
       descr = GC_obj_kinds[kind].ok_descriptor;
       if (GC_obj_kinds[kind].ok_relocate_descr) descr += byte_sz;
@@ -620,7 +623,15 @@ GC_allochblk(size_t sz, int kind, unsigned flags/* IGNORE_OFF_PAGE or 0 */)
          * collect occasionally before allocating new block
          * if many objects have been allocated without GC.
          */
-        GC_gcollect_inner();
+#       ifdef GC_PACER
+          if (GC_incremental && GC_pause_target_us != 0) {
+            /* Do not stop the world for long while paced.  */
+            GC_paced_collect_early();
+          } else
+#       endif
+        /* else */ {
+          GC_gcollect_inner();
+        }
     }
 #endif
 
@@ -401,6 +401,181 @@ STATIC MAY_THREAD_LOCAL GC_bool GC_is_full_gc = FALSE;
 STATIC GC_bool GC_stopped_mark(GC_stop_func stop_func);
 STATIC void GC_finish_collection(void);
 
+#ifdef GC_PACER
+  GC_INNER MAY_THREAD_LOCAL unsigned long GC_pause_target_us = 0;
+                                /* Zero means GC_rate is used instead.  */
+  STATIC MAY_THREAD_LOCAL unsigned GC_pacer_cpu_percent = 0;
+  STATIC MAY_THREAD_LOCAL word GC_pacer_next_slice_us = 0;
+                                /* No slice is run before this time     */
+                                /* (to keep GC_pacer_cpu_percent).      */
+  STATIC MAY_THREAD_LOCAL word GC_pacer_deadline_us = 0;
+                                /* When the work of the current slice   */
+                                /* should stop.                         */
+  STATIC MAY_THREAD_LOCAL GC_bool GC_pacer_finish_pending = FALSE;
+                                /* The marking is done, but the slice   */
+                                /* had no time left for the world-stop  */
+                                /* marking finishing the collection.    */
+  GC_INNER MAY_THREAD_LOCAL GC_bool GC_pacer_sweep_pending = FALSE;
+  STATIC MAY_THREAD_LOCAL struct GC_pacer_stats GC_pacer_totals = { 0 };
+
+# ifndef GC_PACER_MIN_SAMPLE_US
+#   define GC_PACER_MIN_SAMPLE_US 50
+                                /* Shorter slices are too noisy to      */
+                                /* measure the mark throughput.         */
+# endif
+
+  GC_API void GC_CALL GC_set_pause_target(unsigned long max_pause_us,
+                                          unsigned gc_cpu_percent)
+  {
+    GC_pause_target_us = max_pause_us;
+    GC_pacer_cpu_percent = gc_cpu_percent;
+    GC_pacer_next_slice_us = 0;
+  }
+
+  GC_API void GC_CALL GC_get_pacer_stats(struct GC_pacer_stats *stats)
+  {
+    DCL_LOCK_STATE;
+
+    LOCK();
+    *stats = GC_pacer_totals;
+    UNLOCK();
+  }
+
+  /* Microseconds since an arbitrary point (the clock used by GET_TIME  */
+  /* may be too coarse, or measure the processor time).                 */
+  STATIC word GC_pacer_now_us(void)
+  {
+    CLOCK_TYPE now;
+    CLOCK_TYPE zero = CLOCK_TYPE_INITIALIZER;
+
+#   ifdef CLOCK_MONOTONIC
+      struct timespec ts;
+
+      if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return (word)ts.tv_sec * 1000000 + (word)ts.tv_nsec / 1000;
+#   endif
+    GET_TIME(now);
+    return (word)MS_TIME_DIFF(now, zero) * 1000;
+  }
+
+  /* An eighth of the target is left to abandon the world-stop marking  */
+  /* (or to finish the slice otherwise).                                */
+# define GC_PACER_DEADLINE(start_us) \
+                ((start_us) + GC_pause_target_us - GC_pause_target_us / 8)
+
+  STATIC int GC_CALLBACK GC_pacer_stop_func(void)
+  {
+    if ((*GC_default_stop_func)())
+      return 1;
+    return GC_pacer_now_us() >= GC_pacer_deadline_us;
+  }
+
+  STATIC void GC_pacer_end_slice(word start_us)
+  {
+    word end_us = GC_pacer_now_us();
+    word elapsed_us = end_us - start_us;
+
+    GC_pacer_totals.slices++;
+    GC_pacer_totals.last_pause_us = elapsed_us;
+    if (elapsed_us > GC_pacer_totals.max_pause_us)
+      GC_pacer_totals.max_pause_us = elapsed_us;
+    if (elapsed_us > GC_pause_target_us) {
+      GC_pacer_totals.missed++;
+      GC_COND_LOG_PRINTF("GC slice took %lu us (target is %lu us)\n",
+                         (unsigned long)elapsed_us, GC_pause_target_us);
+    }
+    if (GC_pacer_cpu_percent > 0 && GC_pacer_cpu_percent < 100)
+      GC_pacer_next_slice_us = end_us + elapsed_us
+                                        * (100 - GC_pacer_cpu_percent)
+                                        / GC_pacer_cpu_percent;
+  }
+#endif /* GC_PACER */
+
+STATIC MAY_THREAD_LOCAL int GC_n_partial_gcs = 0;
+
+/* Choose between a partial and a full collection before the world-stop */
+/* marking starting an incremental one.  A full collection first sweeps */
+/* the blocks left from the previous one; if stop_func (which may be 0) */
+/* stops it, FALSE is returned and the next call resumes it.            */
+STATIC GC_bool GC_prepare_incremental_collection(GC_stop_func stop_func)
+{
+#   ifdef PARALLEL_MARK
+      if (GC_parallel)
+        GC_wait_for_reclaim();
+#   endif
+    if (GC_need_full_gc || GC_n_partial_gcs >= GC_full_freq) {
+      if (!GC_reclaim_all(stop_func, TRUE))
+        return FALSE;
+#     ifdef GC_PACER
+        GC_pacer_sweep_pending = FALSE;
+#     endif
+      GC_COND_LOG_PRINTF(
+                "***>Full mark for collection #%lu after %lu allocd bytes\n",
+                (unsigned long)GC_gc_no + 1, (unsigned long)GC_bytes_allocd);
+      GC_promote_black_lists();
+      GC_notify_full_gc();
+      GC_clear_marks();
+      GC_n_partial_gcs = 0;
+      GC_is_full_gc = TRUE;
+    } else {
+      GC_n_partial_gcs++;
+    }
+    return TRUE;
+}
+
+/* Start an incremental collection with a world-stop marking, which    */
+/* may finish it at once.                                               */
+STATIC void GC_start_incremental_collection(void)
+{
+    GC_stop_func stop_func;
+#   ifdef GC_PACER
+      word start_us = 0;
+
+      if (GC_pause_target_us != 0) {
+        /* The sweeping done by GC_prepare_incremental_collection is    */
+        /* part of the slice.                                           */
+        start_us = GC_pacer_now_us();
+        GC_pacer_deadline_us = GC_PACER_DEADLINE(start_us);
+        if (!GC_prepare_incremental_collection(GC_pacer_stop_func)) {
+          GC_pacer_end_slice(start_us);
+          return;
+        }
+      } else
+#   endif
+    /* else */ {
+      (void)GC_prepare_incremental_collection((GC_stop_func)0);
+    }
+    /* We try to mark with the world stopped.       */
+    /* If we run out of time, this turns into       */
+    /* incremental marking.                         */
+#   ifndef NO_CLOCK
+      if (GC_time_limit != GC_TIME_UNLIMITED) { GET_TIME(GC_start_time); }
+#   endif
+    /* TODO: If possible, GC_default_stop_func should be    */
+    /* used instead of GC_never_stop_func here.             */
+    stop_func = GC_time_limit == GC_TIME_UNLIMITED ? GC_never_stop_func
+                                                   : GC_timeout_stop_func;
+#   ifdef GC_PACER
+      if (GC_pause_target_us != 0)
+        stop_func = GC_pacer_stop_func;
+#   endif
+    if (GC_stopped_mark(stop_func)) {
+#       ifdef SAVE_CALL_CHAIN
+            GC_save_callers(GC_last_stack);
+#       endif
+        GC_finish_collection();
+    } else {
+        if (!GC_is_full_gc) {
+            /* Count this as the first attempt */
+            GC_n_attempts++;
+        }
+    }
+#   ifdef GC_PACER
+      if (GC_pause_target_us != 0)
+        GC_pacer_end_slice(start_us);
+#   endif
+}
+
 /*
  * Initiate a garbage collection if appropriate.
  * Choose judiciously
@@ -411,57 +586,56 @@ STATIC void GC_maybe_gc(void)
     GC_ASSERT(I_HOLD_LOCK());
     ASSERT_CANCEL_DISABLED();
     if (GC_should_collect()) {
-        static MAY_THREAD_LOCAL int n_partial_gcs = 0;
-
         if (!GC_incremental) {
             /* TODO: If possible, GC_default_stop_func should be used here */
             GC_try_to_collect_inner(GC_never_stop_func);
-            n_partial_gcs = 0;
+            GC_n_partial_gcs = 0;
             return;
-        } else {
-#         ifdef PARALLEL_MARK
-            if (GC_parallel)
-              GC_wait_for_reclaim();
-#         endif
-          if (GC_need_full_gc || n_partial_gcs >= GC_full_freq) {
-            GC_COND_LOG_PRINTF(
-                "***>Full mark for collection #%lu after %lu allocd bytes\n",
-                (unsigned long)GC_gc_no + 1, (unsigned long)GC_bytes_allocd);
-            GC_promote_black_lists();
-            (void)GC_reclaim_all((GC_stop_func)0, TRUE);
-            GC_notify_full_gc();
-            GC_clear_marks();
-            n_partial_gcs = 0;
-            GC_is_full_gc = TRUE;
-          } else {
-            n_partial_gcs++;
-          }
-        }
-        /* We try to mark with the world stopped.       */
-        /* If we run out of time, this turns into       */
-        /* incremental marking.                         */
-#       ifndef NO_CLOCK
-          if (GC_time_limit != GC_TIME_UNLIMITED) { GET_TIME(GC_start_time); }
-#       endif
-        /* TODO: If possible, GC_default_stop_func should be    */
-        /* used instead of GC_never_stop_func here.             */
-        if (GC_stopped_mark(GC_time_limit == GC_TIME_UNLIMITED?
-                            GC_never_stop_func : GC_timeout_stop_func)) {
-#           ifdef SAVE_CALL_CHAIN
-                GC_save_callers(GC_last_stack);
-#           endif
-            GC_finish_collection();
-        } else {
-            if (!GC_is_full_gc) {
-                /* Count this as the first attempt */
-                GC_n_attempts++;
-            }
         }
+        GC_start_incremental_collection();
     }
 }
 
+#ifdef GC_PACER
+  GC_INNER void GC_paced_collect_early(void)
+  {
+    GC_ASSERT(I_HOLD_LOCK());
+    if (!GC_collection_in_progress() && !GC_pacer_finish_pending
+        && !GC_pacer_sweep_pending)
+      GC_start_incremental_collection();
+  }
+#endif
+
 STATIC MAY_THREAD_LOCAL GC_on_collection_event_proc GC_on_collection_event = 0;
 
+#ifdef ESCARGOT
+  STATIC MAY_THREAD_LOCAL GC_before_sweep_proc GC_before_sweep = 0;
+
+  GC_API void GC_CALL GC_set_before_sweep_callback(GC_before_sweep_proc fn)
+  {
+    /* fn may be 0 (means no notifier). */
+    DCL_LOCK_STATE;
+    LOCK();
+    GC_before_sweep = fn;
+    UNLOCK();
+  }
+
+  GC_API GC_before_sweep_proc GC_CALL GC_get_before_sweep_callback(void)
+  {
+    GC_before_sweep_proc fn;
+    DCL_LOCK_STATE;
+    LOCK();
+    fn = GC_before_sweep;
+    UNLOCK();
+    return fn;
+  }
+
+  GC_API size_t GC_CALL GC_get_hblk_size(void)
+  {
+    return HBLKSIZE;
+  }
+#endif /* ESCARGOT */
+
 GC_API void GC_CALL GC_set_on_collection_event(GC_on_collection_event_proc fn)
 {
     /* fn may be 0 (means no event notifier). */
@@ -619,6 +793,99 @@ GC_API int GC_CALL GC_get_max_prior_attempts(void)
     return max_prior_attempts;
 }
 
+#ifdef GC_PACER
+  /* The number of GC_mark_some calls expected to fit in the target     */
+  /* pause, leaving a quarter of it for the slower calls.               */
+  GC_INLINE word GC_pacer_quantum(void)
+  {
+    word quantum;
+
+    if (0 == GC_pacer_totals.units_per_ms)
+      return (word)GC_rate; /* not measured yet */
+    quantum = GC_pacer_totals.units_per_ms * GC_pause_target_us / 1000
+                * 3 / 4;
+    return quantum > 0 ? quantum : 1;
+  }
+
+  STATIC void GC_pacer_update_throughput(word units, word elapsed_us)
+  {
+    word units_per_ms;
+
+    if (elapsed_us < GC_PACER_MIN_SAMPLE_US)
+      return;
+    units_per_ms = units * 1000 / elapsed_us;
+    if (0 == units_per_ms)
+      units_per_ms = 1;
+    if (0 == GC_pacer_totals.units_per_ms) {
+      GC_pacer_totals.units_per_ms = units_per_ms;
+    } else {
+      /* Exponential moving average, favoring the history.      */
+      GC_pacer_totals.units_per_ms =
+                (GC_pacer_totals.units_per_ms * 3 + units_per_ms) / 4;
+    }
+  }
+
+  /* The paced variant of the incremental part of                       */
+  /* GC_collect_a_little_inner.                                         */
+  STATIC void GC_paced_collect_a_little(void)
+  {
+    word start_us = GC_pacer_now_us();
+    word quantum, i;
+    GC_bool finished = GC_pacer_finish_pending;
+
+    if (start_us < GC_pacer_next_slice_us) {
+      GC_pacer_totals.skipped++;
+      return;
+    }
+    GC_pacer_deadline_us = GC_PACER_DEADLINE(start_us);
+    if (GC_pacer_sweep_pending && !GC_collection_in_progress()
+        && !finished) {
+      /* Sweep the blocks left by GC_finish_collection.     */
+      if (GC_reclaim_all(GC_pacer_stop_func, FALSE))
+        GC_pacer_sweep_pending = FALSE;
+      GC_pacer_end_slice(start_us);
+      return;
+    }
+    quantum = GC_pacer_quantum();
+    GC_pacer_totals.quantum = quantum;
+    for (i = 0; !finished && i < quantum; ) {
+      finished = GC_mark_some((ptr_t)0);
+      i++;
+      if (GC_pacer_now_us() >= GC_pacer_deadline_us)
+        break;
+    }
+    if (i > 0)
+      GC_pacer_update_throughput(i, GC_pacer_now_us() - start_us);
+    if (finished) {
+      /* Leave the world-stop marking to the next slice if less than    */
+      /* a quarter of the time is left (GC_mark_some would not be       */
+      /* called again, the collection is not in progress any longer).   */
+      /* The forced one cannot be stopped, so it always starts a slice. */
+      if (i > 0 && (GC_n_attempts >= max_prior_attempts
+                    || GC_pacer_now_us() + GC_pause_target_us / 4
+                       >= GC_pacer_deadline_us)) {
+        GC_pacer_finish_pending = TRUE;
+      } else {
+#       ifdef SAVE_CALL_CHAIN
+          GC_save_callers(GC_last_stack);
+#       endif
+        if (GC_n_attempts < max_prior_attempts) {
+          if (!GC_stopped_mark(GC_pacer_stop_func)) {
+            GC_n_attempts++;
+            GC_pacer_end_slice(start_us);
+            return;
+          }
+        } else {
+          GC_pacer_totals.forced++;
+          (void)GC_stopped_mark(GC_never_stop_func);
+        }
+        GC_finish_collection();
+      }
+    }
+    GC_pacer_end_slice(start_us);
+  }
+#endif /* GC_PACER */
+
 GC_INNER void GC_collect_a_little_inner(int n)
 {
     IF_CANCEL(int cancel_state;)
@@ -627,6 +894,15 @@ GC_INNER void GC_collect_a_little_inner(int n)
     if (GC_dont_gc) return;
 
     DISABLE_CANCEL(cancel_state);
+#   ifdef GC_PACER
+      if (GC_pause_target_us != 0 && GC_incremental
+          && (GC_collection_in_progress() || GC_pacer_finish_pending
+              || GC_pacer_sweep_pending)) {
+        GC_paced_collect_a_little();
+        RESTORE_CANCEL(cancel_state);
+        return;
+      }
+#   endif
     if (GC_incremental && GC_collection_in_progress()) {
         int i;
         int max_deficit = GC_rate * n;
@@ -686,6 +962,113 @@ GC_API int GC_CALL GC_collect_a_little(void)
     return(result);
 }
 
+#ifdef GC_PACER
+  STATIC MAY_THREAD_LOCAL word GC_idle_deadline_us = 0;
+
+  STATIC int GC_CALLBACK GC_idle_stop_func(void)
+  {
+    if ((*GC_default_stop_func)())
+      return 1;
+    return GC_pacer_now_us() >= GC_idle_deadline_us;
+  }
+
+  /* Mark for the collection in progress (or for a new one if anything  */
+  /* has been allocated since the previous collection) and finish it,   */
+  /* unless the deadline passes.  Returns true if no marking is left.   */
+  STATIC GC_bool GC_idle_mark(void)
+  {
+    GC_bool started = FALSE;
+
+    if (!GC_incremental) {
+      /* The work is lost (not resumed) if the collection is aborted.   */
+      return 0 == GC_bytes_allocd
+             || GC_try_to_collect_inner(GC_idle_stop_func);
+    }
+    if (GC_collection_in_progress() || GC_pacer_finish_pending) {
+      while (GC_collection_in_progress()) {
+        if (GC_idle_stop_func())
+          return FALSE;
+        (void)GC_mark_some((ptr_t)0);
+      }
+    } else {
+      if (0 == GC_bytes_allocd)
+        return TRUE;
+      if (!GC_prepare_incremental_collection(GC_idle_stop_func))
+        return FALSE;
+      started = TRUE;
+    }
+    if (!GC_stopped_mark(GC_idle_stop_func)) {
+      /* Resumed by the next call (or by the allocations).      */
+      if (!started || !GC_is_full_gc)
+        GC_n_attempts++;
+      return FALSE;
+    }
+#   ifdef SAVE_CALL_CHAIN
+      GC_save_callers(GC_last_stack);
+#   endif
+    GC_finish_collection();
+    return TRUE;
+  }
+
+  GC_API int GC_CALL GC_collect_until(unsigned long long deadline_ns)
+  {
+    int result = 0;
+    word gc_no;
+    IF_CANCEL(int cancel_state;)
+    DCL_LOCK_STATE;
+
+    if (!EXPECT(GC_is_initialized, TRUE)) GC_init();
+    LOCK();
+    DISABLE_CANCEL(cancel_state);
+    GC_idle_deadline_us = (word)(deadline_ns / 1000);
+    gc_no = GC_gc_no;
+    if (!GC_dont_gc && GC_idle_mark())
+      result |= GC_IDLE_MARK_DONE;
+    if (GC_gc_no != gc_no)
+      result |= GC_IDLE_COLLECTED;
+    if (GC_reclaim_all(GC_idle_stop_func, FALSE))
+      result |= GC_IDLE_SWEEP_DONE;
+#   ifdef USE_MUNMAP
+      if (!GC_idle_stop_func()) {
+        GC_unmap_old();
+        result |= GC_IDLE_UNMAP_DONE;
+      }
+#   else
+      result |= GC_IDLE_UNMAP_DONE;
+#   endif
+    RESTORE_CANCEL(cancel_state);
+    UNLOCK();
+#   ifndef GC_NO_FINALIZATION
+      (void)GC_invoke_finalizers_inner(GC_idle_stop_func);
+      if (!GC_should_invoke_finalizers())
+        result |= GC_IDLE_FINALIZE_DONE;
+#   else
+      result |= GC_IDLE_FINALIZE_DONE;
+#   endif
+    return result;
+  }
+#elif defined(ESCARGOT)
+  /* Without incremental collection or a clock, the collection cannot   */
+  /* be paced.                                                          */
+  GC_API void GC_CALL GC_set_pause_target(unsigned long max_pause_us,
+                                          unsigned gc_cpu_percent)
+  {
+    (void)max_pause_us;
+    (void)gc_cpu_percent;
+  }
+
+  GC_API void GC_CALL GC_get_pacer_stats(struct GC_pacer_stats *stats)
+  {
+    BZERO(stats, sizeof(*stats));
+  }
+
+  GC_API int GC_CALL GC_collect_until(unsigned long long deadline_ns)
+  {
+    (void)deadline_ns;
+    return 0;
+  }
+#endif /* ESCARGOT */
+
 #ifndef NO_CLOCK
   /* Variables for world-stop average delay time statistic computation. */
   /* "divisor" is incremented every world-stop and halved when reached  */
@@ -721,6 +1104,9 @@ STATIC GC_bool GC_stopped_mark(GC_stop_func stop_func)
 #   endif
 
     GC_ASSERT(I_HOLD_LOCK());
+#   ifdef GC_PACER
+      GC_pacer_finish_pending = FALSE;
+#   endif
 #   if !defined(REDIRECT_MALLOC) && defined(USE_WINALLOC)
         GC_add_current_malloc_heap();
 #   endif
@@ -1083,6 +1469,11 @@ STATIC void GC_finish_collection(void)
     GC_VERBOSE_LOG_PRINTF("Bytes recovered before sweep - f.l. count = %ld\n",
                           (long)GC_bytes_found);
 
+#   ifdef ESCARGOT
+      if (GC_before_sweep)
+        GC_before_sweep();
+#   endif
+
     /* Reconstruct free lists to contain everything not marked */
     GC_start_reclaim(FALSE);
     GC_DBGLOG_PRINTF("In-use heap: %d%% (%lu KiB pointers + %lu KiB other)\n",
@@ -1221,6 +1612,44 @@ GC_INNER MAY_THREAD_LOCAL word GC_n_heap_sects = 0;
   }
 #endif
 
+#ifdef HEAP_MAP
+  GC_INNER MAY_THREAD_LOCAL word GC_heap_map[HEAP_MAP_BITS / CPP_WORDSZ];
+  GC_INNER MAY_THREAD_LOCAL ptr_t GC_heap_map_base = NULL;
+  GC_INNER MAY_THREAD_LOCAL unsigned GC_heap_map_shift = 0;
+
+  GC_INNER void GC_update_heap_map(void)
+  {
+    ptr_t lo = GC_heap_sects[0].hs_start;
+    ptr_t hi = lo + GC_heap_sects[0].hs_bytes;
+    unsigned shift = LOG_HBLKSIZE;
+    word i;
+
+    GC_ASSERT(GC_n_heap_sects > 0);
+    for (i = 1; i < GC_n_heap_sects; i++) {
+      ptr_t start = GC_heap_sects[i].hs_start;
+
+      if ((word)start < (word)lo)
+        lo = start;
+      if ((word)(start + GC_heap_sects[i].hs_bytes) > (word)hi)
+        hi = start + GC_heap_sects[i].hs_bytes;
+    }
+    while ((((word)(hi - lo) - 1) >> shift) >= HEAP_MAP_BITS)
+      shift++;
+    BZERO(GC_heap_map, sizeof(GC_heap_map));
+    for (i = 0; i < GC_n_heap_sects; i++) {
+      ptr_t start = GC_heap_sects[i].hs_start;
+      word first = (word)(start - lo) >> shift;
+      word last = ((word)(start - lo) + GC_heap_sects[i].hs_bytes - 1)
+                    >> shift;
+
+      for (; first <= last; first++)
+        GC_heap_map[divWORDSZ(first)] |= (word)1 << modWORDSZ(first);
+    }
+    GC_heap_map_base = lo;
+    GC_heap_map_shift = shift;
+  }
+#endif /* HEAP_MAP */
+
 /*
  * Use the chunk of memory starting at p of size bytes as part of the heap.
  * Assumes p is HBLKSIZE aligned, and bytes is a multiple of HBLKSIZE.
@@ -1282,6 +1711,9 @@ GC_INNER void GC_add_to_heap(struct hblk *p, size_t bytes)
     if ((word)p + bytes >= (word)GC_greatest_plausible_heap_addr) {
         GC_greatest_plausible_heap_addr = (void *)endp;
     }
+#   ifdef HEAP_MAP
+      GC_update_heap_map();
+#   endif
 }
 
 #if !defined(NO_DEBUGGING)
@@ -1329,6 +1761,110 @@ GC_API void GC_CALL GC_set_max_heap_size(GC_word n)
     GC_max_heapsize = n;
 }
 
+#ifdef HEAP_RESERVE
+  STATIC MAY_THREAD_LOCAL word GC_heap_reserve_size = 0;
+  STATIC MAY_THREAD_LOCAL ptr_t GC_heap_reserve_start = NULL;
+  STATIC MAY_THREAD_LOCAL ptr_t GC_heap_reserve_next = NULL;
+                                /* The first byte of the reserved range */
+                                /* not committed yet.                   */
+
+# ifdef GC_COMPRESSED_POINTERS
+    MAY_THREAD_LOCAL char * GC_compressed_base = NULL;
+
+    /* The offset of the heap from GC_compressed_base.  The offsets     */
+    /* below it are left unused, so that the small integers found in    */
+    /* the stacks (and the small negative ones, at the top of the       */
+    /* window) are not mistaken for compressed pointers.                */
+#   ifndef COMPRESSED_HEAP_OFFSET
+#     define COMPRESSED_HEAP_OFFSET ((word)1 << 31)
+#   endif
+
+    /* The offsets from GC_compressed_base should fit in 32 bits.       */
+#   define COMPRESSED_HEAP_MAX_SIZE \
+                (((word)1 << 32) - COMPRESSED_HEAP_OFFSET)
+# endif
+
+  GC_API void GC_CALL GC_set_heap_reserve(GC_word n)
+  {
+    if (NULL == GC_heap_reserve_start)
+      GC_heap_reserve_size = n;
+  }
+
+  GC_API void * GC_CALL GC_get_heap_reserve(GC_word *psize)
+  {
+    if (psize != NULL)
+      *psize = GC_heap_reserve_start != NULL ? GC_heap_reserve_size : 0;
+    return GC_heap_reserve_start;
+  }
+
+  GC_INNER void GC_init_heap_reserve(void)
+  {
+    size_t bytes;
+    ptr_t p;
+
+    if (GC_heap_reserve_start != NULL) return;
+#   ifdef GC_COMPRESSED_POINTERS
+      if (0 == GC_heap_reserve_size
+          || GC_heap_reserve_size > COMPRESSED_HEAP_MAX_SIZE)
+        GC_heap_reserve_size = COMPRESSED_HEAP_MAX_SIZE;
+#   endif
+    GC_heap_reserve_size &= ~(word)(HBLKSIZE - 1);
+    if (0 == GC_heap_reserve_size) return;
+    if (GC_heap_reserve_size > GC_SIZE_MAX - GC_page_size - HBLKSIZE) {
+      WARN("Bad heap reserve size %" WARN_PRIdPTR " - ignoring it\n",
+           GC_heap_reserve_size);
+      GC_heap_reserve_size = 0;
+      return;
+    }
+    bytes = ROUNDUP_PAGESIZE((size_t)GC_heap_reserve_size + HBLKSIZE - 1);
+    p = GC_reserve_mem(bytes);
+    if (NULL == p) {
+#     ifdef GC_COMPRESSED_POINTERS
+        ABORT("Failed to reserve the compressed heap");
+#     else
+        WARN("Failed to reserve %" WARN_PRIdPTR " bytes for the heap\n",
+             (word)bytes);
+        GC_heap_reserve_size = 0;
+        return;
+#     endif
+    }
+    GC_heap_reserve_start = (ptr_t)HBLKPTR(p + HBLKSIZE - 1);
+    GC_heap_reserve_next = GC_heap_reserve_start;
+#   ifdef GC_COMPRESSED_POINTERS
+      GC_compressed_base = (char *)((word)GC_heap_reserve_start
+                                    - COMPRESSED_HEAP_OFFSET);
+#   endif
+    GC_COND_LOG_PRINTF("Reserved %lu MiB for the heap at %p\n",
+                       (unsigned long)(GC_heap_reserve_size >> 20),
+                       (void *)GC_heap_reserve_start);
+  }
+
+  /* Commit the next bytes of the reserved range.  Return NULL if they  */
+  /* do not fit in the rest of the range.                               */
+  STATIC struct hblk * GC_reserved_get_mem(size_t bytes)
+  {
+    ptr_t result = GC_heap_reserve_next;
+
+    if (NULL == result
+        || (word)bytes > (word)(GC_heap_reserve_start + GC_heap_reserve_size
+                                - result)
+        || !GC_commit_mem(result, bytes))
+      return NULL;
+    GC_heap_reserve_next = result + bytes;
+    return (struct hblk *)result;
+  }
+#else
+  GC_API void GC_CALL GC_set_heap_reserve(GC_word n GC_ATTR_UNUSED)
+  {
+  }
+
+  GC_API void * GC_CALL GC_get_heap_reserve(GC_word *psize)
+  {
+    if (psize != NULL) *psize = 0;
+    return NULL;
+  }
+#endif /* !HEAP_RESERVE */
+
 MAY_THREAD_LOCAL GC_word GC_max_retries = 0;
 
 /* This explicitly increases the size of the heap.  It is used          */
@@ -1350,7 +1886,22 @@ GC_INNER GC_bool GC_expand_hp_inner(word n)
         /* Exceeded self-imposed limit */
         return(FALSE);
     }
-    space = GET_MEM(bytes);
+#   ifdef GC_COMPRESSED_POINTERS
+      if ((word)bytes > (word)(GC_heap_reserve_start + GC_heap_reserve_size
+                               - GC_heap_reserve_next)) {
+        /* The heap may not grow out of the reserved range.     */
+        return(FALSE);
+      }
+      space = GC_reserved_get_mem(bytes);
+#   else
+#     ifdef HEAP_RESERVE
+        space = GC_reserved_get_mem(bytes);
+        if (NULL == space)
+#     endif
+      /* else */ {
+        space = GET_MEM(bytes);
+      }
+#   endif
     GC_add_to_our_memory((ptr_t)space, bytes);
     if (space == 0) {
         WARN("Failed to expand heap by %" WARN_PRIdPTR " bytes\n",
@@ -1369,6 +1920,16 @@ GC_INNER GC_bool GC_expand_hp_inner(word n)
             && (word)GC_last_heap_addr < (word)space)) {
         /* Assume the heap is growing up */
         word new_limit = (word)space + (word)bytes + expansion_slop;
+#       ifdef HEAP_RESERVE
+          /* The next sections follow this one up to the end of the     */
+          /* reserved range.                                            */
+          ptr_t reserve_end = GC_heap_reserve_start + GC_heap_reserve_size;
+
+          if ((word)space >= (word)GC_heap_reserve_start
+              && (word)space < (word)reserve_end
+              && new_limit > (word)reserve_end)
+            new_limit = (word)reserve_end;
+#       endif
         if (new_limit > (word)space) {
           GC_greatest_plausible_heap_addr =
             (void *)GC_max((word)GC_greatest_plausible_heap_addr,
@@ -175,6 +175,16 @@ GC_INNER void GC_unpromote_black_lists(void)
     GC_copy_bl(GC_old_stack_bl, GC_incomplete_stack_bl);
 }
 
+#ifdef ISOLATE_PARALLEL_MARK
+  /* For the mark helpers, which black-list in the lists of the owner.  */
+  GC_INNER void GC_get_normal_black_lists(word **old_bl,
+                                          word **incomplete_bl)
+  {
+    *old_bl = GC_old_normal_bl;
+    *incomplete_bl = GC_incomplete_normal_bl;
+  }
+#endif
+
 #if defined(PARALLEL_MARK) && defined(THREAD_SANITIZER)
 # define backlist_set_pht_entry_from_index(db, index) \
                         set_pht_entry_from_index_concurrent(db, index)
@@ -1255,9 +1255,10 @@ GC_API int GC_CALL GC_should_invoke_finalizers(void)
 # endif /* !THREADS */
 }
 
-/* Invoke finalizers for all objects that are ready to be finalized.    */
-/* Should be called without allocation lock.                            */
-GC_API int GC_CALL GC_invoke_finalizers(void)
+/* Invoke finalizers for all objects that are ready to be finalized     */
+/* (or until stop_func, if non-zero, returns true).  Should be called   */
+/* without allocation lock.                                             */
+GC_INNER int GC_invoke_finalizers_inner(GC_stop_func stop_func)
 {
 #if defined(ESCARGOT)
     unsigned char* pnested = GC_check_finalizer_nested();
@@ -1276,6 +1277,8 @@ GC_API int GC_CALL GC_invoke_finalizers(void)
     while (GC_should_invoke_finalizers()) {
         struct finalizable_object * curr_fo;
 
+        if (stop_func != 0 && (*stop_func)())
+            break;
 #       ifdef THREADS
             LOCK();
 #       endif
@@ -1319,12 +1322,17 @@ GC_API int GC_CALL GC_invoke_finalizers(void)
 #if defined(ESCARGOT)
     *pnested = 0; /* Reset since no more finalizers. */
 #ifndef THREADS
-    GC_ASSERT(NULL == GC_fnlz_roots.finalize_now);
+    GC_ASSERT(NULL == GC_fnlz_roots.finalize_now || stop_func != 0);
 #endif
 #endif
     return count;
 }
 
+GC_API int GC_CALL GC_invoke_finalizers(void)
+{
+    return GC_invoke_finalizers_inner(0);
+}
+
 static MAY_THREAD_LOCAL word last_finalizer_notification = 0;
 
 GC_INNER void GC_notify_or_invoke_finalizers(void)
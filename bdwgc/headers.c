@@ -35,7 +35,7 @@ STATIC MAY_THREAD_LOCAL bottom_index * GC_all_bottom_indices_end = 0;
 /* Non-macro version of header location routine */
 GC_INNER hdr * GC_find_header(ptr_t h)
 {
-#   ifdef HASH_TL
+#   if defined(HASH_TL) || defined(FLAT_TL)
         hdr * result;
         GET_HDR(h, result);
         return(result);
@@ -200,9 +200,30 @@ GC_INNER void GC_init_headers(void)
       EXIT();
     }
     BZERO(GC_all_nils, sizeof(bottom_index));
-    for (i = 0; i < TOP_SZ; i++) {
+#   ifdef FLAT_TL
+      /* TOP_SZ pointers, i.e. 512 MiB of address space for each        */
+      /* isolate with the default FLAT_TL_ADDR_BITS and HBLKSIZE.       */
+      GC_top_index = (bottom_index **)GC_get_lazy_mem(TOP_SZ
+                                                * sizeof(bottom_index *));
+      if (GC_top_index == NULL) {
+        /* E.g. the address space is limited (ulimit -v).       */
+        GC_COND_LOG_PRINTF("Cannot reserve flat GC_top_index,"
+                           " using a hash table\n");
+        GC_top_hash = (bottom_index **)GC_scratch_alloc(HASH_TOP_SZ
+                                                * sizeof(bottom_index *));
+        if (GC_top_hash == NULL) {
+          GC_err_printf("Insufficient memory for GC_top_index\n");
+          EXIT();
+        }
+        for (i = 0; i < HASH_TOP_SZ; i++) {
+          GC_top_hash[i] = GC_all_nils;
+        }
+      }
+#   else
+      for (i = 0; i < TOP_SZ; i++) {
         GC_top_index[i] = GC_all_nils;
-    }
+      }
+#   endif
 }
 
 /* Make sure that there is a bottom level index block for address addr. */
@@ -225,6 +246,22 @@ static GC_bool get_index(word addr)
           if (p -> key == hi) return(TRUE);
           p = p -> hash_link;
       }
+#   elif defined(FLAT_TL)
+      if (GC_top_index != NULL) {
+        if (EXPECT(hi >= TOP_SZ, FALSE))
+          return FALSE; /* beyond FLAT_TL_ADDR_BITS */
+        if (GC_top_index[hi] != NULL)
+          return TRUE;
+        i = hi;
+        pi = NULL;
+      } else {
+        i = FLAT_TL_HASH(hi);
+        pi = p = GC_top_hash[i];
+        while (p != GC_all_nils) {
+          if (p -> key == hi) return TRUE;
+          p = p -> hash_link;
+        }
+      }
 #   else
       if (GC_top_index[hi] != GC_all_nils)
         return TRUE;
@@ -235,7 +272,7 @@ static GC_bool get_index(word addr)
       return FALSE;
     BZERO(r, sizeof(bottom_index));
     r -> key = hi;
-#   ifdef HASH_TL
+#   if defined(HASH_TL) || defined(FLAT_TL)
       r -> hash_link = pi;
 #   endif
 
@@ -255,6 +292,12 @@ static GC_bool get_index(word addr)
       r -> asc_link = p;
       *prev = r;
 
+#   ifdef FLAT_TL
+      if (NULL == GC_top_index) {
+        GC_top_hash[i] = r;
+        return TRUE;
+      }
+#   endif
       GC_top_index[i] = r;
     return(TRUE);
 }
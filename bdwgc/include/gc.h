@@ -107,6 +107,24 @@ GC_API GC_word GC_CALL GC_get_gc_no(void);
   GC_API int GC_CALL GC_get_parallel(void);
 #endif
 
+#ifdef GC_THREAD_ISOLATE
+  /* Number of helper threads the calling isolate borrows from a        */
+  /* process-wide pool to mark its heap.  The collector state of an     */
+  /* isolate is thread-local, so the parallel marker above is not       */
+  /* available; instead, the helpers mark with work-stealing mark       */
+  /* stacks from a snapshot of the heap layout published by the owning  */
+  /* thread, which runs the mark procedures itself.  Helpers busy with  */
+  /* another isolate are not waited for.  A marking with helpers runs   */
+  /* to completion in one step, so it is not used while an incremental  */
+  /* collection is paced (see GC_set_pause_target), nor for heaps below */
+  /* a few megabytes or with interior pointers recognized.  Zero (the   */
+  /* default) disables helper marking, as does a collector built        */
+  /* without GCC atomics and POSIX threads.  The setter does not        */
+  /* acquire the GC lock.                                               */
+  GC_API void GC_CALL GC_set_isolate_mark_threads(int);
+  GC_API int GC_CALL GC_get_isolate_mark_threads(void);
+#endif
+
 
 /* Public R/W variables */
 /* The supplied setter and getter functions are preferred for new code. */
@@ -445,6 +463,47 @@ GC_API int GC_CALL GC_get_rate(void);
 GC_API void GC_CALL GC_set_max_prior_attempts(int);
 GC_API int GC_CALL GC_get_max_prior_attempts(void);
 
+#ifdef ESCARGOT
+/* Pace the incremental collection by time instead of GC_rate.  Each    */
+/* slice of the work (run when a collection is in progress and the      */
+/* mutator allocates) marks as much as the measured mark throughput     */
+/* allows within max_pause_us microseconds, also checking the clock;    */
+/* the world-stop marking attempts which start and finish a collection  */
+/* are abandoned at the same limit (up to GC_get_max_prior_attempts()   */
+/* times, the next attempt is not abandoned and may exceed the target, */
+/* so a higher value makes such long pauses rarer).  The sweep of the   */
+/* previous collection is done in the slices too, instead of eagerly,   */
+/* except for the kinds which may be enumerated.  The heap grows while  */
+/* a collection is in progress, by what is allocated until it is        */
+/* finished; to limit it, a collection is started (instead of forced)   */
+/* after 10 MiB are allocated.  If gc_cpu_percent is in 1..99, a slice  */
+/* is skipped unless the time since the previous one is long enough    */
+/* for the latter to be that share of the elapsed time (so the heap may */
+/* grow instead).  Zero max_pause_us (the default) turns the pacer off. */
+/* Ignored if the library is compiled without incremental collection or */
+/* with NO_CLOCK.  Not synchronized.                                    */
+GC_API void GC_CALL GC_set_pause_target(unsigned long /* max_pause_us */,
+                                        unsigned /* gc_cpu_percent */);
+
+/* Statistics of the pacer (accumulated while it is on).  The slices    */
+/* which have taken longer than the target are counted as missed (and   */
+/* logged if GC_print_stats is set).  The slices running a world-stop   */
+/* marking forced after the prior attempts are counted as forced; they  */
+/* are the ones which may miss the target by more than the scheduling   */
+/* of the process.                                                      */
+struct GC_pacer_stats {
+  GC_word slices;               /* slices and world-stop attempts run   */
+  GC_word missed;               /* slices exceeding the target          */
+  GC_word skipped;              /* slices skipped to keep the CPU share */
+  GC_word last_pause_us;
+  GC_word max_pause_us;
+  GC_word quantum;              /* GC_mark_some calls planned per slice */
+  GC_word units_per_ms;         /* measured GC_mark_some calls per ms   */
+  GC_word forced;               /* world-stop markings not abandoned    */
+};
+GC_API void GC_CALL GC_get_pacer_stats(struct GC_pacer_stats *);
+#endif
+
 /* Overrides the default handle-fork mode.  Non-zero value means GC     */
 /* should install proper pthread_atfork handlers.  Has effect only if   */
 /* called before GC_INIT.  Clients should invoke GC_set_handle_fork     */
@@ -532,6 +591,25 @@ GC_API GC_ATTR_DEPRECATED void GC_CALL GC_change_stubborn(const void *);
 /* of the stored pointers.                                              */
 GC_API void GC_CALL GC_end_stubborn_change(const void *) GC_ATTR_NONNULL(1);
 
+/* The card table: an inline alternative to GC_end_stubborn_change for  */
+/* hot pointer stores.  Storing a non-zero byte to                      */
+/* GC_card_table[GC_CARD_INDEX(p)] after a pointer store to p (a heap   */
+/* address) has the same effect as GC_end_stubborn_change(p), without a */
+/* call.  The cards are GC_CARD_BYTES long and the table wraps around   */
+/* (thus a card may stand for several pages, making them all look       */
+/* dirty).  The collector reads and clears the table each time it       */
+/* retrieves the dirty bits in the manual VDB mode; before that mode is */
+/* on, the table is a sink whose contents are ignored, so the store is  */
+/* always safe.  The pointer may change then (the table of each heap is */
+/* allocated lazily), thus it should not be cached by the client.       */
+#define GC_LOG_CARD_BYTES 12
+#define GC_LOG_CARD_TABLE_ENTRIES 18
+#define GC_CARD_BYTES ((GC_word)1 << GC_LOG_CARD_BYTES)
+#define GC_CARD_TABLE_ENTRIES ((GC_word)1 << GC_LOG_CARD_TABLE_ENTRIES)
+#define GC_CARD_INDEX(p) \
+            ((((GC_word)(p)) >> GC_LOG_CARD_BYTES) & (GC_CARD_TABLE_ENTRIES - 1))
+GC_API GC_MAY_THREAD_LOCAL unsigned char *GC_card_table;
+
 /* Return a pointer to the base (lowest address) of an object given     */
 /* a pointer to a location within the object.                           */
 /* I.e., map an interior pointer to the corresponding base pointer.     */
@@ -591,6 +669,48 @@ GC_API int GC_CALL GC_expand_hp(size_t /* number_of_bytes */);
 /* data races).                                                         */
 GC_API void GC_CALL GC_set_max_heap_size(GC_word /* n */);
 
+#ifdef ESCARGOT
+/* Reserve a range of n bytes of the address space (inaccessible, not   */
+/* committed) at GC_init, and commit the heap sections one after the    */
+/* other inside it, so that the heap stays contiguous and the plausible */
+/* heap bounds (checked for each candidate pointer by the conservative  */
+/* scanning) stay tight.  Once the range is exhausted, the heap grows   */
+/* outside of it.  n == 0 (the default) disables the reservation.  The  */
+/* GC_HEAP_RESERVE environment variable overrides n.  Has effect only   */
+/* if called before GC_INIT, and only on 64-bit Linux (no-op otherwise). */
+/* With GC_COMPRESSED_POINTERS, the range is always reserved, and n is  */
+/* limited to (and defaults to) 2 GiB.  Independently of n, the block   */
+/* header index reserves 512 MiB of address space (committed only as   */
+/* it is written) per isolate on 64-bit Linux, and falls back to a hash */
+/* table if that fails (e.g. with ulimit -v).                           */
+GC_API void GC_CALL GC_set_heap_reserve(GC_word /* n */);
+
+/* Return the start of the reserved range (NULL if there is none), and  */
+/* store its size to *psize (if psize is not NULL).  The range does not */
+/* move, so address-based side tables may be indexed by the offset of  */
+/* an object from the start.                                            */
+GC_API void * GC_CALL GC_get_heap_reserve(GC_word * /* psize */);
+
+# ifdef GC_COMPRESSED_POINTERS
+/* The heap of the current thread lies in the range reserved by GC_init */
+/* (of 2 GiB at most), and it does not grow out of it, so a pointer to  */
+/* an object may be stored as its 32-bit offset from GC_compressed_base */
+/* (the offset zero stands for NULL).  The range starts 2 GiB above the */
+/* base, so that small integers in the stacks do not look like offsets  */
+/* of objects.  The collector follows such compressed pointers in the   */
+/* objects allocated with a GC_make_compressed_descriptor descriptor    */
+/* (see gc_typed.h) and in the stacks and registers (each 32-bit half   */
+/* of a word is checked as well); the static data and the               */
+/* conservatively scanned objects should hold the full pointers.        */
+GC_API GC_MAY_THREAD_LOCAL char * GC_compressed_base;
+
+#define GC_COMPRESS_PTR(p) \
+        ((p) != NULL ? (unsigned)((char *)(p) - GC_compressed_base) : 0U)
+#define GC_DECOMPRESS_PTR(v) \
+        ((v) != 0 ? (void *)(GC_compressed_base + (v)) : NULL)
+# endif
+#endif
+
 /* Inform the collector that a certain section of statically allocated  */
 /* memory contains no pointers to garbage collected memory.  Thus it    */
 /* need not be scanned.  This is sometimes important if the application */
@@ -617,6 +737,12 @@ GC_API void GC_CALL GC_remove_roots(void * /* low_address */,
 typedef void (GC_CALLBACK * GC_mark_stack_func)(void);                                     
 GC_API void GC_CALL GC_register_mark_stack_func(GC_mark_stack_func func);
 
+/* Push the registers and the part of the current stack between the    */
+/* stack pointer and the given boundary (toward the cold end of the     */
+/* stack), so that it is scanned conservatively.  For a mark stack      */
+/* function which roots the rest of the stack precisely.                */
+GC_API void GC_CALL GC_push_stack_below(void * /* boundary */);
+
 /* Add a displacement to the set of those considered valid by the       */
 /* collector.  GC_register_displacement(n) means that if p was returned */
 /* by GC_malloc, then (char *)p + n will be considered to be a valid    */
@@ -858,6 +984,31 @@ GC_API int GC_CALL GC_incremental_protection_needs(void);
 /* until it returns 0.                                          */
 GC_API int GC_CALL GC_collect_a_little(void);
 
+#ifdef ESCARGOT
+/* Do the collection work otherwise done on allocation until the        */
+/* deadline (in nanoseconds of clock_gettime(CLOCK_MONOTONIC)) passes,  */
+/* e.g. while the client event loop is idle: finish the collection in   */
+/* progress (or run a new one if anything has been allocated since the  */
+/* previous collection), sweep all the blocks left to be swept lazily,  */
+/* unmap the old free blocks and, with the allocation lock released,    */
+/* invoke the finalizers ready to run.  A step interrupted by the       */
+/* deadline is resumed by the next call (or by the allocations), except */
+/* that a collection which is not incremental is restarted.  Returns    */
+/* the GC_IDLE_ flags of the finished steps.  GC_IDLE_COLLECTED means   */
+/* a collection has completed during the call, so the next one is not   */
+/* triggered until as much is allocated again as after any collection. */
+/* If the library is compiled without incremental collection or with   */
+/* NO_CLOCK, it does nothing and returns 0.                             */
+#define GC_IDLE_COLLECTED       1 /* a collection completed             */
+#define GC_IDLE_MARK_DONE       2 /* no collection left in progress     */
+#define GC_IDLE_SWEEP_DONE      4 /* no blocks left to sweep            */
+#define GC_IDLE_UNMAP_DONE      8 /* old free blocks unmapped           */
+#define GC_IDLE_FINALIZE_DONE   0x10 /* no finalizers left to invoke    */
+#define GC_IDLE_ALL_DONE (GC_IDLE_MARK_DONE | GC_IDLE_SWEEP_DONE \
+                          | GC_IDLE_UNMAP_DONE | GC_IDLE_FINALIZE_DONE)
+GC_API int GC_CALL GC_collect_until(unsigned long long /* deadline_ns */);
+#endif
+
 /* Allocate an object of size lb bytes.  The client guarantees that     */
 /* as long as the object is live, it will be referenced by a pointer    */
 /* that points to somewhere within the first 256 bytes of the object.   */
@@ -1620,6 +1771,19 @@ GC_API void GC_CALL GC_dump(void);
 /* which can be interpreted by gnuplot (and MS Excel of course).        */
 GC_API void GC_CALL GC_dump_for_graph(const char* /* log_file_name */,
                                       const char* /* phase_name */);
+
+/* Heap occupancy as of the end of the last collection.  The counters   */
+/* are maintained by the collector while sweeping, so this is cheap     */
+/* enough to be polled after every collection.                          */
+struct GC_heap_occupancy {
+  GC_word gc_no;                /* collection the counts belong to      */
+  GC_word heap_size;            /* current GC_get_heap_size()           */
+  GC_word blocks_in_use;        /* heap blocks holding live objects     */
+  GC_word block_bytes_in_use;   /* total bytes of these blocks          */
+  GC_word marked_objs;          /* live objects                         */
+  GC_word marked_bytes;         /* total bytes of the live objects      */
+};
+GC_API void GC_CALL GC_get_heap_occupancy(struct GC_heap_occupancy *);
 #endif
 
 /* The same as GC_dump but allows to specify the name of dump and does  */
@@ -237,6 +237,18 @@ GC_API GC_ATTR_MALLOC GC_ATTR_ALLOC_SIZE(1) void * GC_CALL
                 GC_generic_malloc_ignore_off_page(sz, knd)
 #endif /* GC_DEBUG */
 #endif
+
+/* Same as GC_free but the caller supplies the size that was requested  */
+/* (at most GC_size of the object) and the kind of the object.  The     */
+/* size is only checked (in assertions); the free list is chosen by the */
+/* block header.  Large and uncollectable objects fall back to GC_free. */
+GC_API void GC_CALL GC_free_sized(void *, size_t /* lb */, int /* knd */);
+
+#ifdef GC_DEBUG
+# define GC_FREE_SIZED(p, lb, knd) GC_debug_free(p)
+#else
+# define GC_FREE_SIZED(p, lb, knd) GC_free_sized(p, lb, knd)
+#endif
 #endif
 
 /* Generalized version of GC_malloc_[atomic_]uncollectable.     */
@@ -314,6 +326,41 @@ GC_API void GC_CALL GC_set_mark_bit(const void *) GC_ATTR_NONNULL(1);
 
 #ifdef ESCARGOT
 
+/* Set and get the client notifier called at the end of every           */
+/* collection, after finalization has resurrected whatever it needs     */
+/* but before any heap block is swept.  Mark bits are final at this     */
+/* point, so GC_is_marked tells exactly which objects are about to be   */
+/* reclaimed.  Called with the allocation lock held; the same           */
+/* restrictions as for GC_start_callback_proc apply.  A client that     */
+/* installs a notifier should chain to the one it replaces.             */
+typedef void (GC_CALLBACK * GC_before_sweep_proc)(void);
+GC_API void GC_CALL GC_set_before_sweep_callback(GC_before_sweep_proc);
+GC_API GC_before_sweep_proc GC_CALL GC_get_before_sweep_callback(void);
+
+/* Set whether the small object blocks left to sweep after a full       */
+/* collection are swept by a helper thread (shared by all heaps), while */
+/* the client keeps allocating, instead of in the collection pause.     */
+/* The allocator sweeps any block the helper has not reached yet.       */
+/* Blocks of kinds with a reclaim notifier, and uncollectable ones, are */
+/* still swept in the pause.  Ignored in the incremental mode and where */
+/* the helper is not supported.  The default is 0 (off).                */
+GC_API void GC_CALL GC_set_background_sweep(int);
+GC_API int GC_CALL GC_get_background_sweep(void);
+
+/* Set whether the marker delays each candidate pointer it finds in a   */
+/* heap object by a few more candidates, prefetching the object and its */
+/* block header meanwhile, instead of marking it immediately.  This     */
+/* hides most of the cache misses on large heaps with poor locality.    */
+/* The default is 1 (on) where the prefetching is supported, otherwise  */
+/* the setting is ignored.  Not synchronized.                           */
+GC_API void GC_CALL GC_set_mark_prefetch(int);
+GC_API int GC_CALL GC_get_mark_prefetch(void);
+
+/* Return the heap block size (HBLKSIZE).  A small object never crosses */
+/* a block boundary and a large one always starts at a block boundary,  */
+/* so (base & ~(size - 1)) identifies the block holding an object.      */
+GC_API size_t GC_CALL GC_get_hblk_size(void);
+
 struct GC_mark_custom_result {
     GC_word* from;
     GC_word* to;
@@ -338,6 +385,30 @@ GC_API struct GC_ms_entry* GC_mark_and_push_custom(GC_word* addr,
                                                    GC_get_sub_pointer_proc proc,
                                                    struct GC_mark_custom_result* sub_ptrs,
                                                    const int number_of_sub_pointer);
+
+/* A run of adjacent pointer fields of an object, from the first one to */
+/* past the last one.                                                   */
+struct GC_mark_span {
+    GC_word* from;
+    GC_word* to;
+};
+
+/* Like GC_get_next_pointer_proc but stores up to max_spans runs of     */
+/* pointer fields starting at ptr (and before end) to spans, and        */
+/* returns their number.  *next_ptr is set to where to continue, which  */
+/* must be past ptr (otherwise the rest of the object is not scanned),  */
+/* or to end (or past it) once the object is done.  A single field is a */
+/* span of one word.  The spans are pushed in bulk, the longer ones as  */
+/* whole ranges, so an object with many pointers costs only a few       */
+/* calls.                                                               */
+typedef size_t (GC_get_pointer_spans_proc)(GC_word* ptr, GC_word* end,
+                                           GC_word** next_ptr,
+                                           struct GC_mark_span* spans,
+                                           size_t max_spans);
+GC_API struct GC_ms_entry* GC_mark_and_push_custom_spans(GC_word* addr,
+                                                   struct GC_ms_entry *mark_stack_ptr,
+                                                   struct GC_ms_entry *mark_stack_limit,
+                                                   GC_get_pointer_spans_proc proc);
 #endif
 
 /* Push everything in the given range onto the mark stack.              */
@@ -77,6 +77,17 @@ GC_API GC_descr GC_CALL GC_make_descriptor(const GC_word * /* GC_bitmap bm */,
 /* ...                                                                  */
 /* T_descr = GC_make_descriptor(T_bitmap, GC_WORD_LEN(T));              */
 
+#ifdef GC_COMPRESSED_POINTERS
+  GC_API GC_descr GC_CALL GC_make_compressed_descriptor(
+                                const GC_word * /* GC_bitmap bm */,
+                                size_t /* len (number_of_bits_in_bitmap) */);
+                /* The same for the objects with compressed pointers    */
+                /* (see GC_compressed_base): bit i of the bitmap is set */
+                /* if the i-th 32-bit slot of the object may hold a     */
+                /* compressed pointer, and the other slots are assumed  */
+                /* not to contain any pointers.                         */
+#endif
+
 GC_API GC_ATTR_MALLOC GC_ATTR_ALLOC_SIZE(1) void * GC_CALL
         GC_malloc_explicitly_typed(size_t /* size_in_bytes */,
                                    GC_descr /* d */);
@@ -38,7 +38,7 @@ typedef struct hblkhdr hdr;
  * memory references from each pointer validation.
  */
 
-#if CPP_WORDSZ > 32
+#if CPP_WORDSZ > 32 && !defined(FLAT_TL)
 # define HASH_TL
 #endif
 
@@ -51,13 +51,23 @@ typedef struct hblkhdr hdr;
 #endif
 #define BOTTOM_SZ (1 << LOG_BOTTOM_SZ)
 
-#ifndef HASH_TL
+#ifdef FLAT_TL
+# define LOG_TOP_SZ (FLAT_TL_ADDR_BITS - LOG_BOTTOM_SZ - LOG_HBLKSIZE)
+#elif !defined(HASH_TL)
 # define LOG_TOP_SZ (WORDSZ - LOG_BOTTOM_SZ - LOG_HBLKSIZE)
 #else
 # define LOG_TOP_SZ 11
 #endif
 #define TOP_SZ (1 << LOG_TOP_SZ)
 
+#ifdef FLAT_TL
+  /* The hashed top level used instead if the flat table could not be   */
+  /* reserved.                                                          */
+# define LOG_HASH_TOP_SZ 11
+# define HASH_TOP_SZ (1 << LOG_HASH_TOP_SZ)
+# define FLAT_TL_HASH(hi) ((hi) & (HASH_TOP_SZ - 1))
+#endif
+
 /* #define COUNT_HDR_CACHE_HITS  */
 
 #ifdef COUNT_HDR_CACHE_HITS
@@ -132,7 +142,7 @@ typedef struct bi {
                                 /* ascending order...           */
     struct bi * desc_link;      /* ... and in descending order. */
     word key;                   /* high order address bits.     */
-# ifdef HASH_TL
+# if defined(HASH_TL) || defined(FLAT_TL)
     struct bi * hash_link;      /* Hash chain link.             */
 # endif
 } bottom_index;
@@ -150,6 +160,15 @@ typedef struct bi {
                                 /* to a hash chain.                     */
                                 /* The last entry in each chain is      */
                                 /* GC_all_nils.                         */
+                                /* With FLAT_TL, it is a pointer to a   */
+                                /* table indexed by the high order bits */
+                                /* of any address below 2 **            */
+                                /* FLAT_TL_ADDR_BITS, where 0 stands    */
+                                /* for GC_all_nils (so the table is     */
+                                /* committed only where the heap is).   */
+                                /* If the table cannot be reserved, it  */
+                                /* is NULL, and GC_top_hash is used as  */
+                                /* GC_top_index is with HASH_TL.        */
 
 
 #define MAX_JUMP (HBLKSIZE - 1)
@@ -157,8 +176,12 @@ typedef struct bi {
 #define HDR_FROM_BI(bi, p) \
                 ((bi)->index[((word)(p) >> LOG_HBLKSIZE) & (BOTTOM_SZ - 1)])
 #ifndef HASH_TL
-# define BI(p) (GC_top_index \
-              [(word)(p) >> (LOG_BOTTOM_SZ + LOG_HBLKSIZE)])
+# ifdef FLAT_TL
+#   define BI(p) GC_flat_bi(&GC_arrays, (word)(p))
+# else
+#   define BI(p) (GC_top_index \
+                [(word)(p) >> (LOG_BOTTOM_SZ + LOG_HBLKSIZE)])
+# endif
 # define HDR_INNER(p) HDR_FROM_BI(BI(p),p)
 # ifdef SMALL_CONFIG
 #     define HDR(p) GC_find_header((ptr_t)(p))
@@ -45,6 +45,16 @@
 #include "../gc_mark.h"
 #include "gc_priv.h"
 
+#ifdef VECTOR_SCAN
+# if defined(X86_64) && defined(__AVX2__)
+#   include <immintrin.h>
+# elif defined(X86_64)
+#   include <emmintrin.h>
+# else
+#   include <arm_neon.h>
+# endif
+#endif
+
 EXTERN_C_BEGIN
 
 /* The real declarations of the following is in gc_priv.h, so that      */
@@ -76,6 +86,12 @@ GC_EXTERN MAY_THREAD_LOCAL unsigned GC_n_mark_procs;
 
 GC_EXTERN MAY_THREAD_LOCAL size_t GC_mark_stack_size;
 
+#ifdef ISOLATE_PARALLEL_MARK
+  GC_EXTERN MAY_THREAD_LOCAL GC_bool GC_isolate_helpers_running;
+                /* Helper threads are marking the heap of this isolate, */
+                /* so its mark bits are set atomically.                 */
+#endif
+
 #ifdef PARALLEL_MARK
     /*
      * Allow multiple threads to participate in the marking process.
@@ -196,6 +212,34 @@ GC_INLINE mse * GC_push_obj(ptr_t obj, hdr * hhdr,  mse * mark_stack_top,
           } \
         }
 #   endif /* !THREAD_SANITIZER */
+# elif defined(ISOLATE_PARALLEL_MARK)
+    /* Helper markers may set other bits of the same word concurrently. */
+    /* Unlike the above, this exits if another marker won the race.     */
+    /* The helpers always use it, the owner only while they run.        */
+#   define ISOLATE_OR_WORD_EXIT_IF_SET(addr, bits) \
+        { /* cannot use do-while(0) here */ \
+          word my_bits = (bits); \
+          if ((__atomic_load_n(addr, __ATOMIC_RELAXED) & my_bits) != 0 \
+              || (__atomic_fetch_or(addr, my_bits, __ATOMIC_RELAXED) \
+                  & my_bits) != 0) \
+            break; /* go to the enclosing loop end */ \
+        }
+#   define OR_WORD_EXIT_IF_SET(addr, bits) \
+        { /* cannot use do-while(0) here */ \
+          word * my_addr = (addr); \
+          word my_bits = (bits); \
+          if (EXPECT(GC_isolate_helpers_running, FALSE)) { \
+            if ((__atomic_load_n(my_addr, __ATOMIC_RELAXED) & my_bits) != 0 \
+                || (__atomic_fetch_or(my_addr, my_bits, __ATOMIC_RELAXED) \
+                    & my_bits) != 0) \
+              break; /* go to the enclosing loop end */ \
+          } else { \
+            word old = *my_addr; \
+            if ((old & my_bits) != 0) \
+              break; /* go to the enclosing loop end */ \
+            *my_addr = old | my_bits; \
+          } \
+        }
 # else
 #   define OR_WORD_EXIT_IF_SET(addr, bits) \
         { /* cannot use do-while(0) here */ \
@@ -212,11 +256,25 @@ GC_INLINE mse * GC_push_obj(ptr_t obj, hdr * hhdr,  mse * mark_stack_top,
         OR_WORD_EXIT_IF_SET(mark_word_addr, \
                 (word)1 << modWORDSZ(bit_no)); /* contains "break" */ \
     }
+# ifdef ISOLATE_PARALLEL_MARK
+#   define ISOLATE_SET_MARK_BIT_EXIT_IF_SET(hhdr, bit_no) \
+    { /* cannot use do-while(0) here */ \
+        word * mark_word_addr = (hhdr)->hb_marks + divWORDSZ(bit_no); \
+        ISOLATE_OR_WORD_EXIT_IF_SET(mark_word_addr, \
+                (word)1 << modWORDSZ(bit_no)); /* contains "break" */ \
+    }
+# endif
 #endif /* !USE_MARK_BYTES */
 
 #ifdef PARALLEL_MARK
 # define INCR_MARKS(hhdr) \
                 AO_store(&hhdr->hb_n_marks, AO_load(&hhdr->hb_n_marks) + 1)
+#elif defined(ISOLATE_PARALLEL_MARK)
+# define ISOLATE_INCR_MARKS(hhdr) \
+                (void)__atomic_fetch_add(&hhdr->hb_n_marks, 1, __ATOMIC_RELAXED)
+# define INCR_MARKS(hhdr) \
+                (EXPECT(GC_isolate_helpers_running, FALSE) \
+                 ? ISOLATE_INCR_MARKS(hhdr) : (void)(++hhdr->hb_n_marks))
 #else
 # define INCR_MARKS(hhdr) (void)(++hhdr->hb_n_marks)
 #endif
@@ -400,6 +458,86 @@ GC_INLINE mse * GC_push_contents_hdr(ptr_t current, mse * mark_stack_top,
     } while (0)
 #endif
 
+#ifdef VECTOR_SCAN
+# ifndef VECTOR_SCAN_WORDS
+#   define VECTOR_SCAN_WORDS 8 /* a multiple of 4 up to 32 */
+# endif
+
+  /* Return the mask of those of the VECTOR_SCAN_WORDS words at p (not  */
+  /* necessarily aligned to the vector size) which are in [least,       */
+  /* least + span), bit i standing for p[i].  Same as the scalar test   */
+  /* of the plausible heap bounds done by GC_PUSH_ONE_STACK and         */
+  /* GC_mark_from, so span must be zero if there is no heap yet.        */
+  GC_INLINE unsigned GC_plausible_mask(const word *p, word least,
+                                       word span)
+  {
+    unsigned mask = 0;
+    int i;
+#   if defined(X86_64) && defined(__AVX2__)
+      /* There is no unsigned compare, so flip the sign bits.   */
+      const __m256i flip = _mm256_set1_epi64x((long long)SIGNB);
+      const __m256i vleast = _mm256_set1_epi64x((long long)least);
+      const __m256i fspan = _mm256_set1_epi64x((long long)(span ^ SIGNB));
+
+      for (i = 0; i < VECTOR_SCAN_WORDS; i += 4) {
+        __m256i d = _mm256_sub_epi64(
+                        _mm256_loadu_si256((const __m256i *)(p + i)), vleast);
+
+        mask |= (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(
+                    _mm256_cmpgt_epi64(fspan, _mm256_xor_si256(d, flip))))
+                << i;
+      }
+#   elif defined(X86_64)
+      /* SSE2 has no 64-bit compare, so just drop the words which are   */
+      /* out of range by their high half, and check the rest (rare      */
+      /* outside the heap) one by one.                                  */
+      const __m128i flip = _mm_set1_epi32((int)0x80000000);
+      const __m128i vleast = _mm_set1_epi64x((long long)least);
+      const __m128i fspan = _mm_xor_si128(_mm_set1_epi64x((long long)span),
+                                          flip);
+      unsigned m;
+
+      for (i = 0; i < VECTOR_SCAN_WORDS; i += 4) {
+        __m128i d0 = _mm_sub_epi64(
+                        _mm_loadu_si128((const __m128i *)(p + i)), vleast);
+        __m128i d1 = _mm_sub_epi64(
+                        _mm_loadu_si128((const __m128i *)(p + i + 2)), vleast);
+
+        /* Gather the high halves (only) of the 4 results.      */
+        mask |= (unsigned)_mm_movemask_ps(_mm_shuffle_ps(
+                    _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_xor_si128(d0, flip),
+                                                     fspan)),
+                    _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_xor_si128(d1, flip),
+                                                     fspan)),
+                    _MM_SHUFFLE(3, 1, 3, 1))) << i;
+      }
+      mask = ~mask & (unsigned)(((word)1 << VECTOR_SCAN_WORDS) - 1);
+      for (m = mask; m != 0; m &= m - 1) {
+        i = __builtin_ctz(m);
+        if (p[i] - least >= span)
+          mask &= ~(1U << i);
+      }
+#   else
+      static const uint32_t bits[4] = { 1, 2, 4, 8 };
+      const uint64x2_t vleast = vdupq_n_u64((uint64_t)least);
+      const uint64x2_t vspan = vdupq_n_u64((uint64_t)span);
+
+      for (i = 0; i < VECTOR_SCAN_WORDS; i += 4) {
+        uint64x2_t lt0 = vcltq_u64(vsubq_u64(vld1q_u64((const uint64_t *)p
+                                                       + i), vleast), vspan);
+        uint64x2_t lt1 = vcltq_u64(vsubq_u64(vld1q_u64((const uint64_t *)p
+                                                       + i + 2), vleast),
+                                   vspan);
+
+        mask |= vaddvq_u32(vandq_u32(vcombine_u32(vmovn_u64(lt0),
+                                                  vmovn_u64(lt1)),
+                                     vld1q_u32(bits))) << i;
+      }
+#   endif
+    return mask;
+  }
+#endif /* VECTOR_SCAN */
+
 /* As above, but interior pointer recognition as for normal heap pointers. */
 #define GC_PUSH_ONE_HEAP(p,source,mark_stack_top) \
     do { \
@@ -342,6 +342,11 @@ EXTERN_C_BEGIN
                         /* for processing by GC_invoke_finalizers.      */
                         /* Invoked with lock.                           */
 
+  GC_INNER int GC_invoke_finalizers_inner(GC_stop_func stop_func);
+                        /* GC_invoke_finalizers() stopping as soon as   */
+                        /* stop_func (unless 0) returns true.           */
+                        /* Invoked without lock.                        */
+
 # ifndef GC_TOGGLE_REFS_NOT_NEEDED
     GC_INNER void GC_process_togglerefs(void);
                         /* Process the toggle-refs before GC starts.    */
@@ -1044,6 +1049,18 @@ struct hblkhdr {
 #       ifdef MARK_BIT_PER_GRANULE
 #         define LARGE_BLOCK 0x20
 #       endif
+#   ifdef BACKGROUND_SWEEP
+      unsigned char hb_sweep_state;
+                                /* Hands the block over between the     */
+                                /* background sweeper and the           */
+                                /* allocator.  Accessed atomically.     */
+#       define SWEEP_NONE 0     /* Not queued for the sweeper, or       */
+                                /* already taken by the allocator.      */
+#       define SWEEP_QUEUED 1   /* On a reclaim list, not swept yet.    */
+#       define SWEEP_BUSY 2     /* Being swept by the sweeper.          */
+#       define SWEEP_DONE 3     /* Swept, the free objects are in       */
+                                /* hb_swept_list.                       */
+#   endif
     unsigned short hb_last_reclaimed;
                                 /* Value of GC_gc_no when block was     */
                                 /* last allocated or swept. May wrap.   */
@@ -1070,6 +1087,11 @@ struct hblkhdr {
                                 /* mod BYTES_TO_GRANULES(hb_sz), except */
                                 /* for large blocks.  See GC_obj_map.   */
 #   endif
+#   ifdef BACKGROUND_SWEEP
+      ptr_t hb_swept_list;      /* Valid in the SWEEP_DONE state: the   */
+      ptr_t hb_swept_tail;      /* free objects found by the sweeper,   */
+      word hb_swept_bytes;      /* the last one and their total size.   */
+#   endif
 #   ifdef PARALLEL_MARK
       volatile AO_t hb_n_marks; /* Number of set mark bits, excluding   */
                                 /* the one always set at the end.       */
@@ -1296,6 +1318,17 @@ struct _GC_arrays {
                           /* composite objects.                 */
   word _atomic_in_use;    /* Number of bytes in the accessible  */
                           /* atomic objects.                    */
+# ifdef ESCARGOT
+#   define GC_marked_objs GC_arrays._marked_objs
+    word _marked_objs;    /* Number of accessible objects.        */
+#   define GC_blocks_in_use GC_arrays._blocks_in_use
+    word _blocks_in_use;  /* Number of heap blocks holding        */
+                          /* accessible objects.                  */
+#   define GC_block_bytes_in_use GC_arrays._block_bytes_in_use
+    word _block_bytes_in_use; /* Size of these blocks in bytes.   */
+                          /* All three are recomputed by          */
+                          /* GC_reclaim_block, like the above.    */
+# endif
 # ifdef USE_MUNMAP
 #   define GC_unmapped_bytes GC_arrays._unmapped_bytes
     word _unmapped_bytes;
@@ -1375,7 +1408,9 @@ struct _GC_arrays {
     volatile page_hash_table _dirty_pages;
                         /* Pages dirtied since last GC_read_dirty. */
 # endif
-# if (defined(CHECKSUMS) && defined(GWW_VDB)) || defined(PROC_VDB)
+# if (defined(CHECKSUMS) && (defined(GWW_VDB) || defined(UFFD_VDB) \
+                              || defined(SOFT_VDB))) \
+     || defined(PROC_VDB)
 #   define GC_written_pages GC_arrays._written_pages
     page_hash_table _written_pages;     /* Pages ever dirtied   */
 # endif
@@ -1405,7 +1440,12 @@ struct _GC_arrays {
   struct roots _static_roots[MAX_ROOT_SETS];
   struct exclusion _excl_table[MAX_EXCLUSIONS];
   /* Block header index; see gc_headers.h */
-  bottom_index * _top_index[TOP_SZ];
+# ifdef FLAT_TL
+    bottom_index ** _top_index;
+    bottom_index ** _top_hash;
+# else
+    bottom_index * _top_index[TOP_SZ];
+# endif
 };
 
 GC_API_PRIV GC_FAR MAY_THREAD_LOCAL struct _GC_arrays GC_arrays;
@@ -1436,9 +1476,35 @@ GC_API_PRIV GC_FAR MAY_THREAD_LOCAL struct _GC_arrays GC_arrays;
 #define GC_size_map GC_arrays._size_map
 #define GC_static_roots GC_arrays._static_roots
 #define GC_top_index GC_arrays._top_index
+#ifdef FLAT_TL
+# define GC_top_hash GC_arrays._top_hash
+#endif
 #define GC_uobjfreelist GC_arrays._uobjfreelist
 #define GC_valid_offsets GC_arrays._valid_offsets
 
+#ifdef FLAT_TL
+  /* The bottom index for addr in the header index of arrays (see BI    */
+  /* in gc_hdrs.h).                                                     */
+  GC_INLINE bottom_index * GC_flat_bi(struct _GC_arrays *arrays, word addr)
+  {
+    word hi = addr >> (LOG_BOTTOM_SZ + LOG_HBLKSIZE);
+    bottom_index **top_index = arrays -> _top_index;
+    bottom_index *bi;
+
+    if (EXPECT(top_index != NULL && hi < TOP_SZ, TRUE)) {
+      bi = top_index[hi];
+      return bi != NULL ? bi : arrays -> _all_nils;
+    }
+    if (NULL == top_index) {
+      bi = arrays -> _top_hash[FLAT_TL_HASH(hi)];
+      while (bi -> key != hi && bi != arrays -> _all_nils)
+        bi = bi -> hash_link;
+      return bi;
+    }
+    return arrays -> _all_nils; /* beyond FLAT_TL_ADDR_BITS */
+  }
+#endif
+
 #define beginGC_arrays ((ptr_t)(&GC_arrays))
 #define endGC_arrays (((ptr_t)(&GC_arrays)) + (sizeof GC_arrays))
 #define USED_HEAP_SIZE (GC_heapsize - GC_large_free_bytes)
@@ -1854,6 +1920,11 @@ struct hblk * GC_is_black_listed(struct hblk * h, word len);
 
 GC_INNER void GC_promote_black_lists(void);
                         /* Declare an end to a black listing phase.     */
+#ifdef ISOLATE_PARALLEL_MARK
+  GC_INNER void GC_get_normal_black_lists(word **old_bl,
+                                          word **incomplete_bl);
+                        /* Those of the current isolate.        */
+#endif
 GC_INNER void GC_unpromote_black_lists(void);
                         /* Approximately undo the effect of the above.  */
                         /* This actually loses some information, but    */
@@ -1864,6 +1935,25 @@ GC_INNER ptr_t GC_scratch_alloc(size_t bytes);
                                 /* small objects.  Deallocation is not  */
                                 /* possible.  May return NULL.          */
 
+#ifdef FLAT_TL
+  GC_INNER ptr_t GC_get_lazy_mem(size_t bytes);
+                                /* Reserve zero-filled memory whose     */
+                                /* pages are committed only once they   */
+                                /* are written.  May return NULL.       */
+#endif
+
+#ifdef HEAP_RESERVE
+  GC_INNER ptr_t GC_reserve_mem(size_t bytes);
+                                /* Reserve an inaccessible range of the */
+                                /* address space.  May return NULL.     */
+  GC_INNER GC_bool GC_commit_mem(ptr_t start, size_t bytes);
+                                /* Make a part of a reserved range      */
+                                /* accessible.  FALSE on failure.       */
+  GC_INNER void GC_init_heap_reserve(void);
+                                /* Reserve the range for the heap       */
+                                /* sections (see GC_set_heap_reserve).  */
+#endif
+
 #ifdef GWW_VDB
   /* GC_scratch_recycle_no_gww() not used.      */
 #else
@@ -1935,6 +2025,13 @@ GC_INNER void GC_continue_reclaim(word sz, int kind);
 GC_INNER GC_bool GC_reclaim_all(GC_stop_func stop_func, GC_bool ignore_old);
                                 /* Reclaim all blocks.  Abort (in a     */
                                 /* consistent state) if f returns TRUE. */
+#ifdef BACKGROUND_SWEEP
+  GC_INNER void GC_finish_background_sweep(void);
+                                /* Stop the background sweeper, and     */
+                                /* sweep the blocks left which must be  */
+                                /* swept before marking.  Called        */
+                                /* before mark bits are changed.        */
+#endif
 GC_INNER ptr_t GC_reclaim_generic(struct hblk * hbp, hdr *hhdr, size_t sz,
                                   GC_bool init, ptr_t list,
                                   signed_word *count);
@@ -2038,6 +2135,26 @@ GC_INNER hdr * GC_find_header(ptr_t h);
 GC_INNER void GC_add_to_heap(struct hblk *p, size_t bytes);
                         /* Add a HBLKSIZE aligned chunk to the heap.    */
 
+#ifdef HEAP_MAP
+  /* A coarse map of the heap sections: bit i is set if some section    */
+  /* overlaps the i-th chunk of (1 << GC_heap_map_shift) bytes at       */
+  /* GC_heap_map_base.  All the sections are within the mapped range.   */
+# define HEAP_MAP_BITS 4096
+  GC_EXTERN MAY_THREAD_LOCAL word GC_heap_map[HEAP_MAP_BITS / CPP_WORDSZ];
+  GC_EXTERN MAY_THREAD_LOCAL ptr_t GC_heap_map_base;
+  GC_EXTERN MAY_THREAD_LOCAL unsigned GC_heap_map_shift;
+
+  /* Could the value p point into a heap section?       */
+# define IN_HEAP_MAP(p, base, shift) \
+        ((((word)(p) - (word)(base)) >> (shift)) < HEAP_MAP_BITS \
+         && (GC_heap_map[divWORDSZ(((word)(p) - (word)(base)) >> (shift))] \
+             >> modWORDSZ(((word)(p) - (word)(base)) >> (shift)) & 1) != 0)
+
+  GC_INNER void GC_update_heap_map(void);
+                        /* Rebuild the map after a heap section is      */
+                        /* added.                                       */
+#endif
+
 #ifdef USE_PROC_FOR_LIBRARIES
   GC_INNER void GC_add_to_our_memory(ptr_t p, size_t bytes);
                         /* Add a chunk to GC_our_memory.        */
@@ -2212,6 +2329,18 @@ GC_EXTERN MAY_THREAD_LOCAL GC_bool GC_print_back_height;
   GC_INNER void GC_dirty_inner(const void *p); /* does not require locking */
 # define GC_dirty(p) (GC_manual_vdb ? GC_dirty_inner(p) : (void)0)
 # define REACHABLE_AFTER_DIRTY(p) GC_reachable_here(p)
+
+# ifdef GC_PACER
+    GC_EXTERN MAY_THREAD_LOCAL unsigned long GC_pause_target_us;
+                /* The pause time target of the incremental collection  */
+                /* in microseconds, zero if it is not paced.            */
+    GC_EXTERN MAY_THREAD_LOCAL GC_bool GC_pacer_sweep_pending;
+                /* GC_start_reclaim left the sweep of the blocks to the */
+                /* paced slices.                                        */
+    GC_INNER void GC_paced_collect_early(void);
+                /* Start a paced collection before GC_should_collect    */
+                /* would, unless one is in progress.                    */
+# endif
 #endif /* !GC_DISABLE_INCREMENTAL */
 
 /* Same as GC_base but excepts and returns a pointer to const object.   */
@@ -873,9 +873,13 @@ EXTERN_C_BEGIN
  *   MPROTECT_VDB: Write protect the heap and catch faults.
  *   GWW_VDB: Use win32 GetWriteWatch primitive.
  *   PROC_VDB: Use the SVR4 /proc primitives to read dirty bits.
+ *   SOFT_VDB: Use the Linux soft-dirty bits of /proc/self/pagemap.
+ *   UFFD_VDB: Use the Linux userfaultfd asynchronous write-protection.
  *
- * The first and second one may be combined, in which case a runtime
- * selection will be made, based on GetWriteWatch availability.
+ * The first one may be combined with the second, the fourth or the
+ * fifth one (or with the both latter), in which case a runtime selection
+ * will be made, based on GetWriteWatch, userfaultfd or soft-dirty bits
+ * availability.
  *
  * An architecture may define DYNAMIC_LOADING if dyn_load.c
  * defined GC_register_dynamic_libraries() for the architecture.
@@ -3221,6 +3225,21 @@ EXTERN_C_BEGIN
 # undef MPROTECT_VDB
 #endif
 
+#if defined(LINUX) && defined(MPROTECT_VDB) && !defined(GC_THREAD_ISOLATE) \
+    && !defined(NO_SOFT_VDB)
+  /* Read the soft-dirty bits of the kernel if supported, with          */
+  /* MPROTECT_VDB as the fallback.  Clearing the bits affects the whole */
+  /* process, so this is unusable with several isolated heaps.          */
+# define SOFT_VDB
+#endif
+
+#if defined(LINUX) && defined(MPROTECT_VDB) && !defined(NO_UFFD_VDB)
+  /* Use the userfaultfd asynchronous write-protection and PAGEMAP_SCAN */
+  /* if supported (Linux 6.7+), with SOFT_VDB and MPROTECT_VDB as the   */
+  /* fallbacks.  Only the heap sections are affected.                   */
+# define UFFD_VDB
+#endif
+
 #if !defined(PCR_VDB) && !defined(PROC_VDB) && !defined(MPROTECT_VDB) \
     && !defined(GWW_VDB) && !defined(DEFAULT_VDB) \
     && !defined(GC_DISABLE_INCREMENTAL)
@@ -3570,6 +3589,93 @@ EXTERN_C_BEGIN
 # define MARK_BIT_PER_GRANULE   /* Usually faster       */
 #endif
 
+#if defined(GC_THREAD_ISOLATE) && defined(ESCARGOT) && defined(__GNUC__) \
+    && !defined(MSWIN32) && !defined(MSWINCE) \
+    && defined(MARK_BIT_PER_GRANULE) && !defined(USE_MARK_BYTES) \
+    && !defined(KEEP_BACK_PTRS) && !defined(NO_ISOLATE_PARALLEL_MARK)
+  /* Mark the heap of an isolate with threads borrowed from a pool.     */
+  /* Mark bits are set with atomic operations (GCC builtins).           */
+# define ISOLATE_PARALLEL_MARK
+#endif
+
+#if defined(ESCARGOT) && defined(__GNUC__) && !defined(MSWIN32) \
+    && !defined(MSWINCE) && !defined(PARALLEL_MARK) \
+    && !defined(NO_BACKGROUND_SWEEP)
+  /* Small object blocks may be swept by a helper thread after a        */
+  /* collection (see GC_set_background_sweep).                          */
+# define BACKGROUND_SWEEP
+#endif
+
+#if defined(ESCARGOT) && !defined(GC_DISABLE_INCREMENTAL) \
+    && !defined(NO_CLOCK) && !defined(NO_GC_PACER)
+  /* The incremental collection may be paced by a pause time target     */
+  /* (see GC_set_pause_target).                                         */
+# define GC_PACER
+#endif
+
+#if defined(ESCARGOT) && !defined(SMALL_CONFIG) && GC_GNUC_PREREQ(3, 0) \
+    && !defined(NO_PREFETCH) && !defined(NO_MARK_PREFETCH_FIFO)
+  /* GC_mark_from may delay marking the candidate pointers in a FIFO,   */
+  /* prefetching their objects and headers (see GC_set_mark_prefetch).  */
+# define MARK_PREFETCH_FIFO
+#endif
+
+#if defined(ESCARGOT) && !defined(SMALL_CONFIG) && GC_GNUC_PREREQ(4, 4) \
+    && CPP_WORDSZ == 64 && ALIGNMENT == 8 && !defined(NEED_FIXUP_POINTER) \
+    && !defined(ENABLE_TRACE) && !defined(NO_VECTOR_SCAN) \
+    && ((defined(X86_64) && (defined(__AVX2__) \
+                             || (defined(__SSE2__) \
+                                 && defined(VECTOR_SCAN_SSE2)))) \
+        || (defined(AARCH64) && defined(__ARM_NEON)))
+  /* The conservative scanning loops test several words at once        */
+  /* against the plausible heap bounds (see GC_plausible_mask).  The    */
+  /* SSE2 variant (lacking a 64-bit compare) is hardly faster than the  */
+  /* scalar loop, so it is used only if VECTOR_SCAN_SSE2 is defined.    */
+# define VECTOR_SCAN
+#endif
+
+#if defined(ESCARGOT) && !defined(USE_MARK_BYTES) \
+    && defined(MARK_BIT_PER_GRANULE) && GC_GNUC_PREREQ(3, 4) \
+    && !defined(NO_BITMAP_SWEEP)
+  /* The small object blocks are swept a mark word at a time rather     */
+  /* than an object at a time (see GC_reclaim_bits).                    */
+# define BITMAP_SWEEP
+#endif
+
+#if defined(ESCARGOT) && defined(LINUX) && CPP_WORDSZ == 64 \
+    && (defined(X86_64) || defined(AARCH64)) && !defined(SMALL_CONFIG) \
+    && !defined(NO_FLAT_TL)
+  /* The top level of the block header index is a flat table covering   */
+  /* the whole user address space, instead of a hash table (see         */
+  /* gc_hdrs.h).  It is reserved at once, and the kernel commits only   */
+  /* the pages which are written.                                       */
+# define FLAT_TL
+# ifndef FLAT_TL_ADDR_BITS
+#   define FLAT_TL_ADDR_BITS 48
+# endif
+#endif
+
+#if defined(ESCARGOT) && defined(LINUX) && CPP_WORDSZ == 64 \
+    && defined(MMAP_SUPPORTED) && !defined(ESCARGOT_USE_32BIT_IN_64BIT) \
+    && !defined(NO_HEAP_RESERVE)
+  /* The heap sections may be committed one after the other in a range  */
+  /* of the address space reserved at GC_init (see GC_set_heap_reserve), */
+  /* so that the plausible heap bounds stay tight.                      */
+# define HEAP_RESERVE
+#endif
+
+#if defined(VECTOR_SCAN) || defined(HEAP_RESERVE)
+  /* The heap sections are recorded in a coarse bitmap, so that the     */
+  /* conservative scanning of the stacks drops the values between the   */
+  /* sections with a subtraction, a compare and a bit test (see         */
+  /* IN_HEAP_MAP) instead of a header lookup.                           */
+# define HEAP_MAP
+#endif
+
+#if defined(GC_COMPRESSED_POINTERS) && !defined(HEAP_RESERVE)
+# error GC_COMPRESSED_POINTERS requires HEAP_RESERVE (64-bit Linux)
+#endif
+
 /* Some static sanity tests.    */
 #if !defined(CPPCHECK)
 # if defined(MARK_BIT_PER_GRANULE) && defined(MARK_BIT_PER_OBJ)
@@ -619,6 +619,48 @@ GC_API void GC_CALL GC_free(void * p)
     }
 }
 
+#ifdef ESCARGOT
+GC_API void GC_CALL GC_free_sized(void * p, size_t lb, int knd)
+{
+    hdr *hhdr;
+    size_t ngranules;
+    size_t sz;
+    struct obj_kind * ok;
+    void **flh;
+    DCL_LOCK_STATE;
+
+    if (p == 0) return;
+    if (IS_UNCOLLECTABLE(knd)) {
+        GC_free(p);
+        return;
+    }
+    /* The size class is taken from the header: lb does not determine   */
+    /* it, e.g. GC_size_map[GC_size(p)] is the next class up if         */
+    /* EXTRA_BYTES is not zero.                                         */
+    hhdr = HDR(p);
+    sz = (size_t)hhdr->hb_sz;
+    if (sz > MAXOBJBYTES) {
+        GC_free(p);
+        return;
+    }
+    GC_ASSERT(GC_base(p) == p);
+    GC_ASSERT(lb <= sz);
+    GC_ASSERT(hhdr -> hb_obj_kind == knd);
+    (void)lb;
+    ngranules = BYTES_TO_GRANULES(sz);
+    ok = &GC_obj_kinds[knd];
+    LOCK();
+    GC_bytes_freed += sz;
+    if (ok -> ok_init && EXPECT(sz > sizeof(word), TRUE)) {
+        BZERO((word *)p + 1, sz-sizeof(word));
+    }
+    flh = &(ok -> ok_freelist[ngranules]);
+    obj_link(p) = *flh;
+    *flh = (ptr_t)p;
+    UNLOCK();
+}
+#endif /* ESCARGOT */
+
 /* Explicitly deallocate an object p when we already hold lock.         */
 /* Only used for internally allocated objects, so we can take some      */
 /* shortcuts.                                                           */
@@ -32,6 +32,11 @@
 # include <excpt.h>
 #endif
 
+#ifdef ISOLATE_PARALLEL_MARK
+# include <pthread.h>
+# include <sched.h>
+#endif
+
 /* Make arguments appear live to compiler.  Put here to minimize the    */
 /* risk of inlining.  Used to minimize junk left in registers.          */
 GC_ATTR_NOINLINE
@@ -248,6 +253,9 @@ GC_API int GC_CALL GC_is_marked(const void *p)
  */
 GC_INNER void GC_clear_marks(void)
 {
+#   ifdef BACKGROUND_SWEEP
+      GC_finish_background_sweep();
+#   endif
     GC_apply_to_all_blocks(clear_marks_for_block, (word)0);
     GC_objects_are_marked = FALSE;
     GC_mark_state = MS_INVALID;
@@ -259,6 +267,9 @@ GC_INNER void GC_clear_marks(void)
 GC_INNER void GC_initiate_gc(void)
 {
     GC_ASSERT(I_HOLD_LOCK());
+#   ifdef BACKGROUND_SWEEP
+      GC_finish_background_sweep();
+#   endif
 #   ifndef GC_DISABLE_INCREMENTAL
         if (GC_incremental) {
 #         ifdef CHECKSUMS
@@ -301,6 +312,18 @@ STATIC struct hblk * GC_push_next_marked_uncollectable(struct hblk *h);
 
 static void alloc_mark_stack(size_t);
 
+#ifdef ISOLATE_PARALLEL_MARK
+  STATIC MAY_THREAD_LOCAL int GC_isolate_mark_threads = 0;
+  GC_INNER MAY_THREAD_LOCAL GC_bool GC_isolate_helpers_running = FALSE;
+
+# ifndef ISOLATE_MARK_MIN_HEAPSIZE
+    /* Smaller heaps are not worth waking the helpers for.      */
+#   define ISOLATE_MARK_MIN_HEAPSIZE ((word)1024 * HBLKSIZE)
+# endif
+
+  STATIC GC_bool GC_isolate_parallel_mark(void);
+#endif
+
 /* Perform a small amount of marking.                   */
 /* We try to touch roughly a page of memory.            */
 /* Return TRUE if we just finished a mark phase.        */
@@ -394,6 +417,26 @@ static void alloc_mark_stack(size_t);
                   }
                   break;
                 }
+#           endif
+#           ifdef ISOLATE_PARALLEL_MARK
+              /* Runs to completion as well, so not while paced.        */
+              if (GC_isolate_mark_threads > 0 && !GC_all_interior_pointers
+#                 ifdef GC_PACER
+                    && !(GC_incremental && GC_pause_target_us != 0)
+#                 endif
+                  && GC_heapsize >= ISOLATE_MARK_MIN_HEAPSIZE
+                  && (word)GC_mark_stack_top >= (word)GC_mark_stack
+                  && GC_isolate_parallel_mark()) {
+                GC_ASSERT(GC_mark_stack_top == GC_mark_stack - 1);
+                if (GC_mark_stack_too_small) {
+                  alloc_mark_stack(2*GC_mark_stack_size);
+                }
+                if (GC_mark_state == MS_ROOTS_PUSHED) {
+                  GC_mark_state = MS_NONE;
+                  return(TRUE);
+                }
+                break;
+              }
 #           endif
             if ((word)GC_mark_stack_top >= (word)GC_mark_stack) {
                 MARK_FROM_MARK_STACK();
@@ -626,6 +669,65 @@ GC_INNER mse * GC_signal_mark_stack_overflow(mse *msp)
     return(msp - GC_MARK_STACK_DISCARDS);
 }
 
+#ifdef MARK_PREFETCH_FIFO
+  STATIC MAY_THREAD_LOCAL GC_bool GC_mark_prefetch = TRUE;
+
+# ifndef MARK_FIFO_SIZE
+#   define MARK_FIFO_SIZE 16    /* Must be power of 2.                  */
+# endif
+
+  /* A candidate pointer waiting in the FIFO of GC_mark_from.   */
+  typedef struct {
+    ptr_t mf_obj;       /* Passed the heap bounds test; 0 if vacant.    */
+    ptr_t mf_source;
+  } mark_fifo_entry;
+
+# if defined(MARK_BIT_PER_GRANULE) && defined(USE_MARK_BYTES)
+#   define MARK_FIFO_MARK_ADDR(hhdr, p) \
+                ((hhdr) -> hb_marks + BYTES_TO_GRANULES(HBLKDISPL(p)))
+# elif defined(MARK_BIT_PER_GRANULE)
+#   define MARK_FIFO_MARK_ADDR(hhdr, p) \
+                ((hhdr) -> hb_marks \
+                 + divWORDSZ(BYTES_TO_GRANULES(HBLKDISPL(p))))
+# else
+#   define MARK_FIFO_MARK_ADDR(hhdr, p) ((hhdr) -> hb_marks)
+# endif
+
+  /* Add p to the FIFO, marking the oldest candidate if it is full.     */
+  /* The object p points to and the slot of its header in the index     */
+  /* are prefetched on entry; halfway through, the header and the mark  */
+  /* bits are prefetched, so HC_GET_HDR and SET_MARK_BIT_EXIT_IF_SET    */
+  /* rarely miss the cache when the candidate leaves.                   */
+# define MARK_FIFO_PUSH(p, source) \
+    do { \
+      mark_fifo_entry *mf_new = mark_fifo \
+                        + (mark_fifo_pos & (MARK_FIFO_SIZE - 1)); \
+      mark_fifo_entry *mf_mid = mark_fifo \
+                        + ((mark_fifo_pos + MARK_FIFO_SIZE / 2) \
+                           & (MARK_FIFO_SIZE - 1)); \
+      bottom_index *mf_bi; \
+      \
+      mark_fifo_pos++; \
+      if (mf_new -> mf_obj != NULL) \
+        PUSH_CONTENTS(mf_new -> mf_obj, mark_stack_top, \
+                      mark_stack_limit, mf_new -> mf_source); \
+      mf_new -> mf_obj = (p); \
+      mf_new -> mf_source = (source); \
+      PREFETCH(p); \
+      GET_BI(p, mf_bi); \
+      PREFETCH(&HDR_FROM_BI(mf_bi, p)); \
+      if (mf_mid -> mf_obj != NULL) { \
+        hdr *mf_hhdr; \
+        \
+        GET_HDR(mf_mid -> mf_obj, mf_hhdr); \
+        if (!IS_FORWARDING_ADDR_OR_NIL(mf_hhdr)) { \
+          PREFETCH(mf_hhdr); \
+          PREFETCH(MARK_FIFO_MARK_ADDR(mf_hhdr, mf_mid -> mf_obj)); \
+        } \
+      } \
+    } while (0)
+#endif /* MARK_PREFETCH_FIFO */
+
 /*
  * Mark objects pointed to by the regions described by
  * mark stack entries between mark_stack and mark_stack_top,
@@ -652,11 +754,25 @@ GC_INNER mse * GC_mark_from(mse *mark_stack_top, mse *mark_stack,
   ptr_t greatest_ha = (ptr_t)GC_greatest_plausible_heap_addr;
   ptr_t least_ha = (ptr_t)GC_least_plausible_heap_addr;
   DECLARE_HDR_CACHE;
+# ifdef VECTOR_SCAN
+    word ha_span = (word)greatest_ha > (word)least_ha
+                    ? (word)greatest_ha - (word)least_ha : 0;
+# endif
+# ifdef MARK_PREFETCH_FIFO
+    GC_bool use_fifo = GC_mark_prefetch;
+    mark_fifo_entry mark_fifo[MARK_FIFO_SIZE];
+    word mark_fifo_pos = 0;
+# endif
 
 # define SPLIT_RANGE_WORDS 128  /* Must be power of 2.          */
 
   GC_objects_are_marked = TRUE;
   INIT_HDR_CACHE;
+# ifdef MARK_PREFETCH_FIFO
+    if (use_fifo)
+      BZERO(mark_fifo, sizeof(mark_fifo));
+  again:
+# endif
 # ifdef OS2 /* Use untweaked version to circumvent compiler problem */
     while ((word)mark_stack_top >= (word)mark_stack && credit >= 0)
 # else
@@ -755,8 +871,15 @@ GC_INNER mse * GC_mark_from(mse *mark_stack_top, mse *mark_stack,
                                   (void *)current);
                   }
 #               endif /* ENABLE_TRACE */
-                PUSH_CONTENTS((ptr_t)current, mark_stack_top,
-                              mark_stack_limit, current_p);
+#               ifdef MARK_PREFETCH_FIFO
+                  if (use_fifo) {
+                    MARK_FIFO_PUSH((ptr_t)current, current_p);
+                  } else
+#               endif
+                /* else */ {
+                  PUSH_CONTENTS((ptr_t)current, mark_stack_top,
+                                mark_stack_limit, current_p);
+                }
               }
             }
             descr <<= 1;
@@ -834,7 +957,48 @@ GC_INNER mse * GC_mark_from(mse *mark_stack_top, mse *mark_stack,
 
 #     ifndef SMALL_CONFIG
         word deferred;
+#     endif
+
+#     ifdef MARK_PREFETCH_FIFO
+        if (use_fifo) {
+#         ifdef VECTOR_SCAN
+            while ((word)(current_p + (VECTOR_SCAN_WORDS - 1) * sizeof(word))
+                   <= (word)limit) {
+              unsigned mask = GC_plausible_mask((word *)current_p,
+                                                (word)least_ha, ha_span);
+
+              PREFETCH(current_p + PREF_DIST*CACHE_LINE_SIZE);
+              while (mask != 0) {
+                ptr_t src = current_p + __builtin_ctz(mask) * sizeof(word);
+
+                mask &= mask - 1;
+                current = *(word *)src;
+                MARK_FIFO_PUSH((ptr_t)current, src);
+              }
+              current_p += VECTOR_SCAN_WORDS * sizeof(word);
+            }
+#         endif
+          while ((word)current_p <= (word)limit) {
+            current = *(word *)current_p;
+            FIXUP_POINTER(current);
+            PREFETCH(current_p + PREF_DIST*CACHE_LINE_SIZE);
+            if (current >= (word)least_ha && current < (word)greatest_ha) {
+#             ifdef ENABLE_TRACE
+                if (GC_trace_addr == current_p) {
+                  GC_log_printf("GC #%u: considering(1) %p -> %p\n",
+                                (unsigned)GC_gc_no, (void *)current_p,
+                                (void *)current);
+                }
+#             endif /* ENABLE_TRACE */
+              MARK_FIFO_PUSH((ptr_t)current, current_p);
+            }
+            current_p += ALIGNMENT;
+          }
+          continue;
+        }
+#     endif
 
+#     ifndef SMALL_CONFIG
         /* Try to prefetch the next pointer to be examined ASAP.        */
         /* Empirically, this also seems to help slightly without        */
         /* prefetches, at least on linux/X86.  Presumably this loop     */
@@ -865,6 +1029,25 @@ GC_INNER mse * GC_mark_from(mse *mark_stack_top, mse *mark_stack,
         }
 #     endif
 
+#     ifdef VECTOR_SCAN
+        while ((word)(current_p + (VECTOR_SCAN_WORDS - 1) * sizeof(word))
+               <= (word)limit) {
+          unsigned mask = GC_plausible_mask((word *)current_p,
+                                            (word)least_ha, ha_span);
+
+          PREFETCH(current_p + PREF_DIST*CACHE_LINE_SIZE);
+          while (mask != 0) {
+            ptr_t src = current_p + __builtin_ctz(mask) * sizeof(word);
+
+            mask &= mask - 1;
+            current = *(word *)src;
+            PREFETCH((ptr_t)current);
+            PUSH_CONTENTS((ptr_t)current, mark_stack_top,
+                          mark_stack_limit, src);
+          }
+          current_p += VECTOR_SCAN_WORDS * sizeof(word);
+        }
+#     endif
       while ((word)current_p <= (word)limit) {
         /* Empirically, unrolling this loop doesn't help a lot. */
         /* Since PUSH_CONTENTS expands to a lot of code,        */
@@ -906,9 +1089,611 @@ GC_INNER mse * GC_mark_from(mse *mark_stack_top, mse *mark_stack,
 #     endif
     }
   }
+# ifdef MARK_PREFETCH_FIFO
+    if (use_fifo) {
+      /* Mark the candidates left in the FIFO (the oldest first), and   */
+      /* go on with what they have pushed unless out of credit.         */
+      word i;
+
+      for (i = 0; i < MARK_FIFO_SIZE; i++) {
+        mark_fifo_entry *mf = mark_fifo
+                        + ((mark_fifo_pos + i) & (MARK_FIFO_SIZE - 1));
+
+        if (mf -> mf_obj != NULL) {
+          PUSH_CONTENTS(mf -> mf_obj, mark_stack_top, mark_stack_limit,
+                        mf -> mf_source);
+          mf -> mf_obj = NULL;
+        }
+      }
+      if (credit >= 0 && (word)mark_stack_top >= (word)mark_stack)
+        goto again;
+    }
+# endif
   return mark_stack_top;
 }
 
+#ifdef ESCARGOT
+  GC_API void GC_CALL GC_set_mark_prefetch(int value)
+  {
+#   ifdef MARK_PREFETCH_FIFO
+      GC_mark_prefetch = value != 0;
+#   else
+      (void)value;
+#   endif
+  }
+
+  GC_API int GC_CALL GC_get_mark_prefetch(void)
+  {
+#   ifdef MARK_PREFETCH_FIFO
+      return (int)GC_mark_prefetch;
+#   else
+      return 0;
+#   endif
+  }
+#endif /* ESCARGOT */
+
+#ifdef ISOLATE_PARALLEL_MARK
+/* Helper marking for GC_THREAD_ISOLATE heaps.  The collector state of  */
+/* an isolate lives in the thread-local storage of its owner thread,    */
+/* so helper threads cannot run GC_mark_from.  Instead, the owner       */
+/* publishes what marking needs (the block header index, the valid      */
+/* offsets and the plausible heap bounds, none of which change while    */
+/* marking) in a mark job, and borrows idle threads from a pool shared  */
+/* by all isolates.  Every participant marks from a private deque, and  */
+/* exports its oldest entries for the others to steal while some        */
+/* participant is out of work.  Helpers only scan length and bitmap     */
+/* descriptors; objects with a mark procedure are handed over to the    */
+/* owner, which runs the procedure with its own state.  Mark bits are   */
+/* set atomically while the helpers run (see OR_WORD_EXIT_IF_SET), so   */
+/* the procedures may run concurrently with them; the serial marking    */
+/* keeps the plain updates.  Invalid candidates are black-listed in the */
+/* lists of the owner, as by GC_add_to_black_list_normal.               */
+
+# define ISOLATE_SHARE_ENTRIES 64   /* Max entries exported at once.    */
+# define ISOLATE_SHARE_BYTES 2048   /* Larger ranges are split.         */
+# define ISOLATE_INITIAL_DEQUE_SIZE 1024        /* Must be power of 2.  */
+# define ISOLATE_MAX_MARK_THREADS 64
+
+typedef struct {
+  mse *md_entries;      /* Ring buffer of md_mask+1 entries.            */
+  word md_mask;
+  word md_bottom;       /* Index of the oldest entry.                   */
+  word md_top;          /* Index past the newest entry.                 */
+  pthread_mutex_t md_lock;      /* Protects md_shared.                  */
+  word md_shared_n;     /* Number of exported entries, read atomically. */
+  mse md_shared[ISOLATE_SHARE_ENTRIES];
+  hdr_cache_entry md_hdr_cache[HDR_CACHE_SIZE];
+} GC_isolate_marker;
+
+typedef struct GC_isolate_mark_job_s {
+  struct _GC_arrays *mj_arrays;         /* Those of the owner.          */
+  ptr_t mj_least_ha;
+  ptr_t mj_greatest_ha;
+  word *mj_old_normal_bl;               /* The black lists of the owner */
+  word *mj_incomplete_normal_bl;        /* (the latter set atomically). */
+  GC_isolate_marker *mj_markers;        /* The owner is marker 0.       */
+  int mj_n_markers;
+  int mj_idle;          /* Markers out of work, updated atomically.     */
+  int mj_done;
+  pthread_mutex_t mj_owner_lock;        /* Protects the entries only    */
+  mse *mj_owner_entries;                /* the owner can process.       */
+  word mj_owner_size;
+  word mj_owner_n;      /* Read atomically.                             */
+  /* The rest is protected by GC_isolate_pool_lock.     */
+  int mj_unclaimed;     /* Helpers reserved but not yet joined.         */
+  int mj_finished;      /* Helpers done with the job.                   */
+  struct GC_isolate_mark_job_s *mj_next;
+} GC_isolate_mark_job;
+
+/* The pool of helper threads is shared by all isolates.        */
+STATIC pthread_mutex_t GC_isolate_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+STATIC pthread_cond_t GC_isolate_pool_cond = PTHREAD_COND_INITIALIZER;
+                                /* Signaled when a job is posted.       */
+STATIC pthread_cond_t GC_isolate_pool_done_cond = PTHREAD_COND_INITIALIZER;
+                                /* Signaled when a helper leaves a job. */
+STATIC int GC_isolate_pool_threads = 0;
+STATIC int GC_isolate_pool_idle = 0;
+STATIC GC_isolate_mark_job *GC_isolate_pool_jobs = NULL;
+
+STATIC void GC_isolate_grow_deque(GC_isolate_marker *m)
+{
+  word size = m -> md_mask + 1;
+  word n = m -> md_top - m -> md_bottom;
+  mse *entries = (mse *)malloc(2 * size * sizeof(mse));
+  word i;
+
+  if (NULL == entries)
+    ABORT("Insufficient memory for isolate mark deque");
+  for (i = 0; i < n; i++)
+    entries[i] = m -> md_entries[(m -> md_bottom + i) & m -> md_mask];
+  free(m -> md_entries);
+  m -> md_entries = entries;
+  m -> md_mask = 2 * size - 1;
+  m -> md_bottom = 0;
+  m -> md_top = n;
+}
+
+GC_INLINE void GC_isolate_push(GC_isolate_marker *m, ptr_t start,
+                               word descr)
+{
+  mse *entry;
+
+  if (EXPECT(m -> md_top - m -> md_bottom > m -> md_mask, FALSE))
+    GC_isolate_grow_deque(m);
+  entry = m -> md_entries + (m -> md_top++ & m -> md_mask);
+  entry -> mse_start = start;
+  entry -> mse_descr.w = descr;
+}
+
+/* Make up to half of the entries of m available to the others.  */
+STATIC void GC_isolate_export(GC_isolate_marker *m)
+{
+  word n = (m -> md_top - m -> md_bottom) / 2;
+  word i;
+
+  if (n > ISOLATE_SHARE_ENTRIES)
+    n = ISOLATE_SHARE_ENTRIES;
+  pthread_mutex_lock(&m -> md_lock);
+  if (0 == m -> md_shared_n) {
+    for (i = 0; i < n; i++)
+      m -> md_shared[i] = m -> md_entries[m -> md_bottom++ & m -> md_mask];
+    __atomic_store_n(&m -> md_shared_n, n, __ATOMIC_SEQ_CST);
+  }
+  pthread_mutex_unlock(&m -> md_lock);
+}
+
+/* Move the entries exported by victim (possibly m itself) to m.  */
+STATIC GC_bool GC_isolate_steal_from(GC_isolate_marker *m,
+                                     GC_isolate_marker *victim)
+{
+  word n, i;
+
+  if (0 == __atomic_load_n(&victim -> md_shared_n, __ATOMIC_SEQ_CST))
+    return FALSE;
+  pthread_mutex_lock(&victim -> md_lock);
+  n = victim -> md_shared_n;
+  for (i = 0; i < n; i++)
+    GC_isolate_push(m, victim -> md_shared[i].mse_start,
+                    victim -> md_shared[i].mse_descr.w);
+  __atomic_store_n(&victim -> md_shared_n, 0, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&victim -> md_lock);
+  return n != 0;
+}
+
+STATIC GC_bool GC_isolate_steal(GC_isolate_mark_job *job, int id)
+{
+  int i;
+
+  /* Take back our own entries first. */
+  for (i = 0; i < job -> mj_n_markers; i++) {
+    if (GC_isolate_steal_from(job -> mj_markers + id, job -> mj_markers
+                              + (id + i) % job -> mj_n_markers))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+STATIC GC_bool GC_isolate_work_available(GC_isolate_mark_job *job, int id)
+{
+  int i;
+
+  if (0 == id && __atomic_load_n(&job -> mj_owner_n, __ATOMIC_SEQ_CST) != 0)
+    return TRUE;
+  for (i = 0; i < job -> mj_n_markers; i++) {
+    if (__atomic_load_n(&job -> mj_markers[i].md_shared_n,
+                        __ATOMIC_SEQ_CST) != 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/* Queue an entry for the owner.  Called by the helpers.  */
+STATIC void GC_isolate_defer(GC_isolate_mark_job *job, ptr_t start,
+                             word descr)
+{
+  pthread_mutex_lock(&job -> mj_owner_lock);
+  if (job -> mj_owner_n == job -> mj_owner_size) {
+    word size = job -> mj_owner_size > 0 ? 2 * job -> mj_owner_size
+                                         : ISOLATE_SHARE_ENTRIES;
+    mse *entries = (mse *)realloc(job -> mj_owner_entries,
+                                  size * sizeof(mse));
+
+    if (NULL == entries)
+      ABORT("Insufficient memory for isolate mark deque");
+    job -> mj_owner_entries = entries;
+    job -> mj_owner_size = size;
+  }
+  job -> mj_owner_entries[job -> mj_owner_n].mse_start = start;
+  job -> mj_owner_entries[job -> mj_owner_n].mse_descr.w = descr;
+  __atomic_store_n(&job -> mj_owner_n, job -> mj_owner_n + 1,
+                   __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&job -> mj_owner_lock);
+}
+
+STATIC GC_bool GC_isolate_take_deferred(GC_isolate_mark_job *job)
+{
+  word n, i;
+
+  if (0 == __atomic_load_n(&job -> mj_owner_n, __ATOMIC_SEQ_CST))
+    return FALSE;
+  pthread_mutex_lock(&job -> mj_owner_lock);
+  n = job -> mj_owner_n;
+  for (i = 0; i < n; i++)
+    GC_isolate_push(job -> mj_markers, job -> mj_owner_entries[i].mse_start,
+                    job -> mj_owner_entries[i].mse_descr.w);
+  __atomic_store_n(&job -> mj_owner_n, 0, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&job -> mj_owner_lock);
+  return n != 0;
+}
+
+/* GET_HDR with the header index of the owner.  */
+GC_INLINE hdr * GC_isolate_find_header(GC_isolate_mark_job *job, ptr_t p)
+{
+  bottom_index *bi;
+# ifdef HASH_TL
+    word hi = (word)p >> (LOG_BOTTOM_SZ + LOG_HBLKSIZE);
+
+    bi = job -> mj_arrays -> _top_index[TL_HASH(hi)];
+    while (bi -> key != hi && bi != job -> mj_arrays -> _all_nils)
+      bi = bi -> hash_link;
+# elif defined(FLAT_TL)
+    bi = GC_flat_bi(job -> mj_arrays, (word)p);
+# else
+    bi = job -> mj_arrays -> _top_index[(word)p
+                                        >> (LOG_BOTTOM_SZ + LOG_HBLKSIZE)];
+# endif
+  return HDR_FROM_BI(bi, p);
+}
+
+/* GC_add_to_black_list_normal with the black lists of the owner.       */
+STATIC void GC_isolate_black_list(GC_isolate_mark_job *job, ptr_t p,
+                                  hdr *hhdr)
+{
+  word index = PHT_HASH((word)p);
+
+  if (!job -> mj_arrays -> _modws_valid_offsets[(word)p & (sizeof(word)-1)])
+    return;
+  if (NULL == hhdr || get_pht_entry_from_index(job -> mj_old_normal_bl,
+                                               index))
+    (void)__atomic_fetch_or(job -> mj_incomplete_normal_bl
+                                + divWORDSZ(index),
+                            (word)1 << modWORDSZ(index), __ATOMIC_RELAXED);
+}
+
+/* The counterpart of PUSH_CONTENTS for the helpers.  As interior       */
+/* pointers are not recognized, only a pointer to the first block of    */
+/* an object can be valid (see GC_header_cache_miss).                   */
+GC_INLINE void GC_isolate_mark_and_push(GC_isolate_mark_job *job,
+                                        GC_isolate_marker *m, ptr_t current)
+{
+  hdr_cache_entry *hdr_cache = m -> md_hdr_cache;
+  hdr_cache_entry *hce = HCE(current);
+  hdr *hhdr;
+
+  do {
+    size_t displ, gran_displ, gran_offset, byte_offset;
+    ptr_t base = current;
+
+    if (EXPECT(HCE_VALID_FOR(hce, current), TRUE)) {
+      hhdr = hce -> hce_hdr;
+    } else {
+      hhdr = GC_isolate_find_header(job, current);
+      if (IS_FORWARDING_ADDR_OR_NIL(hhdr)) {
+        if (NULL == hhdr)
+          GC_isolate_black_list(job, current, NULL);
+        break;
+      }
+      if (HBLK_IS_FREE(hhdr)) {
+        GC_isolate_black_list(job, current, hhdr);
+        break;
+      }
+      hce -> block_addr = (word)current >> LOG_HBLKSIZE;
+      hce -> hce_hdr = hhdr;
+    }
+    displ = HBLKDISPL(current);
+    gran_displ = BYTES_TO_GRANULES(displ);
+    gran_offset = hhdr -> hb_map[gran_displ];
+    byte_offset = displ & (GRANULE_BYTES - 1);
+    if (EXPECT((gran_offset | byte_offset) != 0, FALSE)) {
+      size_t obj_displ;
+
+      if ((hhdr -> hb_flags & LARGE_BLOCK) != 0) {
+        obj_displ = displ;
+        base = (ptr_t)hhdr -> hb_block;
+        gran_displ = 0;
+      } else {
+        obj_displ = GRANULES_TO_BYTES(gran_offset) + byte_offset;
+        gran_displ -= gran_offset;
+        base -= obj_displ;
+      }
+      if (!job -> mj_arrays -> _valid_offsets[obj_displ]) {
+        GC_isolate_black_list(job, current, hhdr);
+        break;
+      }
+    }
+    ISOLATE_SET_MARK_BIT_EXIT_IF_SET(hhdr, gran_displ);
+                                                /* contains "break" */
+    ISOLATE_INCR_MARKS(hhdr);
+    if (hhdr -> hb_descr != 0)
+      GC_isolate_push(m, base, hhdr -> hb_descr);
+  } while (0);
+}
+
+STATIC void GC_isolate_mark_entry(GC_isolate_mark_job *job, int id,
+                                  ptr_t current_p, word descr)
+{
+  GC_isolate_marker *m = job -> mj_markers + id;
+  ptr_t greatest_ha = job -> mj_greatest_ha;
+  ptr_t least_ha = job -> mj_least_ha;
+  ptr_t limit;
+  word current;
+
+  for (;;) {
+    switch (descr & GC_DS_TAGS) {
+      case GC_DS_LENGTH:
+        if (descr > ISOLATE_SHARE_BYTES) {
+          /* Keep splitting the range, the first halves can be stolen. */
+          word new_size = (descr/2) & ~(word)(sizeof(word)-1);
+
+          GC_isolate_push(m, current_p, new_size + sizeof(word));
+                                        /* makes sure we handle         */
+                                        /* misaligned pointers.         */
+          current_p += new_size;
+          descr -= new_size;
+          continue;
+        }
+        if (descr < sizeof(word))
+          return;
+        limit = current_p + descr - sizeof(word);
+        for (; (word)current_p <= (word)limit; current_p += ALIGNMENT) {
+          current = *(word *)current_p;
+          FIXUP_POINTER(current);
+          if (current >= (word)least_ha && current < (word)greatest_ha) {
+            PREFETCH((ptr_t)current);
+            GC_isolate_mark_and_push(job, m, (ptr_t)current);
+          }
+        }
+        return;
+      case GC_DS_BITMAP:
+        descr &= ~GC_DS_TAGS;
+        for (; descr != 0; descr <<= 1, current_p += sizeof(word)) {
+          if ((descr & SIGNB) == 0)
+            continue;
+          current = *(word *)current_p;
+          FIXUP_POINTER(current);
+          if (current >= (word)least_ha && current < (word)greatest_ha) {
+            PREFETCH((ptr_t)current);
+            GC_isolate_mark_and_push(job, m, (ptr_t)current);
+          }
+        }
+        return;
+      case GC_DS_PROC:
+        if (id != 0) {
+          GC_isolate_defer(job, current_p, descr);
+        } else {
+          /* The mark stack of the owner is empty while the helpers     */
+          /* run, so the procedure can use it.                          */
+          mse *top = (*PROC(descr))((word *)current_p, GC_mark_stack - 1,
+                                    GC_mark_stack_limit, ENV(descr));
+          mse *entry;
+
+          for (entry = GC_mark_stack; (word)entry <= (word)top; entry++)
+            GC_isolate_push(m, entry -> mse_start, entry -> mse_descr.w);
+        }
+        return;
+      case GC_DS_PER_OBJECT:
+        /* See GC_mark_from.    */
+        if ((signed_word)descr >= 0) {
+          descr = *(word *)(current_p + descr - GC_DS_PER_OBJECT);
+        } else {
+          ptr_t type_descr = *(ptr_t *)current_p;
+
+          if (EXPECT(0 == type_descr, FALSE))
+            return;
+          descr = *(word *)(type_descr
+                            - ((signed_word)descr + (GC_INDIR_PER_OBJ_BIAS
+                                                     - GC_DS_PER_OBJECT)));
+        }
+        if (0 == descr)
+          return;
+        continue;
+    }
+  }
+}
+
+/* Mark until no participant of the job has work left.  The owner      */
+/* detects the termination: once all markers are idle, nobody can       */
+/* export new entries or queue more entries for the owner.              */
+STATIC void GC_isolate_do_mark(GC_isolate_mark_job *job, int id)
+{
+  GC_isolate_marker *m = job -> mj_markers + id;
+
+  for (;;) {
+    while (m -> md_top != m -> md_bottom) {
+      mse *entry = m -> md_entries + (--m -> md_top & m -> md_mask);
+
+      GC_isolate_mark_entry(job, id, entry -> mse_start,
+                            entry -> mse_descr.w);
+      if (m -> md_top - m -> md_bottom > 1
+          && __atomic_load_n(&job -> mj_idle, __ATOMIC_RELAXED) > 0
+          && 0 == __atomic_load_n(&m -> md_shared_n, __ATOMIC_RELAXED))
+        GC_isolate_export(m);
+    }
+    if ((0 == id && GC_isolate_take_deferred(job))
+        || GC_isolate_steal(job, id))
+      continue;
+
+    __atomic_add_fetch(&job -> mj_idle, 1, __ATOMIC_SEQ_CST);
+    for (;;) {
+      if (__atomic_load_n(&job -> mj_done, __ATOMIC_SEQ_CST))
+        return;
+      if (0 == id
+          && __atomic_load_n(&job -> mj_idle, __ATOMIC_SEQ_CST)
+                == job -> mj_n_markers
+          && 0 == __atomic_load_n(&job -> mj_owner_n, __ATOMIC_SEQ_CST)) {
+        __atomic_store_n(&job -> mj_done, 1, __ATOMIC_SEQ_CST);
+        return;
+      }
+      if (GC_isolate_work_available(job, id)) {
+        __atomic_sub_fetch(&job -> mj_idle, 1, __ATOMIC_SEQ_CST);
+        if ((0 == id && GC_isolate_take_deferred(job))
+            || GC_isolate_steal(job, id))
+          break;
+        __atomic_add_fetch(&job -> mj_idle, 1, __ATOMIC_SEQ_CST);
+      }
+      sched_yield();
+    }
+  }
+}
+
+STATIC void * GC_isolate_mark_helper(void *arg GC_ATTR_UNUSED)
+{
+  pthread_mutex_lock(&GC_isolate_pool_lock);
+  for (;;) {
+    GC_isolate_mark_job *job = GC_isolate_pool_jobs;
+    int id;
+
+    while (job != NULL && 0 == job -> mj_unclaimed)
+      job = job -> mj_next;
+    if (NULL == job) {
+      pthread_cond_wait(&GC_isolate_pool_cond, &GC_isolate_pool_lock);
+      continue;
+    }
+    id = job -> mj_n_markers - job -> mj_unclaimed--;
+    pthread_mutex_unlock(&GC_isolate_pool_lock);
+
+    GC_isolate_do_mark(job, id);
+
+    pthread_mutex_lock(&GC_isolate_pool_lock);
+    GC_isolate_pool_idle++;
+    job -> mj_finished++;
+    pthread_cond_broadcast(&GC_isolate_pool_done_cond);
+  }
+  return NULL;
+}
+
+/* Mark from the mark stack with the help of the pool.  Returns FALSE,  */
+/* leaving the mark stack untouched, if no helper is available.         */
+STATIC GC_bool GC_isolate_parallel_mark(void)
+{
+  GC_isolate_mark_job job;
+  GC_isolate_mark_job **link;
+  int n_helpers, i;
+  mse *entry;
+
+  pthread_mutex_lock(&GC_isolate_pool_lock);
+  while (GC_isolate_pool_threads < GC_isolate_mark_threads) {
+    pthread_attr_t attr;
+    pthread_t thread;
+    int err;
+
+    if (pthread_attr_init(&attr) != 0)
+      break;
+    (void)pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    err = pthread_create(&thread, &attr, GC_isolate_mark_helper, NULL);
+    (void)pthread_attr_destroy(&attr);
+    if (err != 0) {
+      WARN("Creating isolate marker thread failed\n", 0);
+      break;
+    }
+    GC_isolate_pool_threads++;
+    GC_isolate_pool_idle++;
+  }
+  n_helpers = GC_isolate_pool_idle < GC_isolate_mark_threads
+              ? GC_isolate_pool_idle : GC_isolate_mark_threads;
+  GC_isolate_pool_idle -= n_helpers;
+  pthread_mutex_unlock(&GC_isolate_pool_lock);
+  if (0 == n_helpers)
+    return FALSE;
+
+  BZERO(&job, sizeof(job));
+  job.mj_arrays = &GC_arrays;
+  job.mj_least_ha = (ptr_t)GC_least_plausible_heap_addr;
+  job.mj_greatest_ha = (ptr_t)GC_greatest_plausible_heap_addr;
+  GC_get_normal_black_lists(&job.mj_old_normal_bl,
+                            &job.mj_incomplete_normal_bl);
+  job.mj_n_markers = n_helpers + 1;
+  job.mj_markers = (GC_isolate_marker *)calloc(job.mj_n_markers,
+                                               sizeof(GC_isolate_marker));
+  if (NULL == job.mj_markers)
+    ABORT("Insufficient memory for isolate markers");
+  for (i = 0; i < job.mj_n_markers; i++) {
+    GC_isolate_marker *m = job.mj_markers + i;
+
+    m -> md_entries = (mse *)malloc(ISOLATE_INITIAL_DEQUE_SIZE
+                                    * sizeof(mse));
+    if (NULL == m -> md_entries)
+      ABORT("Insufficient memory for isolate mark deque");
+    m -> md_mask = ISOLATE_INITIAL_DEQUE_SIZE - 1;
+    pthread_mutex_init(&m -> md_lock, NULL);
+  }
+  pthread_mutex_init(&job.mj_owner_lock, NULL);
+
+  /* The roots are spread by the owner exporting them.  */
+  for (entry = GC_mark_stack; (word)entry <= (word)GC_mark_stack_top;
+       entry++)
+    GC_isolate_push(job.mj_markers, entry -> mse_start,
+                    entry -> mse_descr.w);
+  GC_mark_stack_top = GC_mark_stack - 1;
+  GC_objects_are_marked = TRUE;
+
+  GC_isolate_helpers_running = TRUE;
+  pthread_mutex_lock(&GC_isolate_pool_lock);
+  job.mj_unclaimed = n_helpers;
+  job.mj_next = GC_isolate_pool_jobs;
+  GC_isolate_pool_jobs = &job;
+  pthread_cond_broadcast(&GC_isolate_pool_cond);
+  pthread_mutex_unlock(&GC_isolate_pool_lock);
+
+  GC_isolate_do_mark(&job, 0);
+
+  /* The helpers may still be reading the job.  */
+  pthread_mutex_lock(&GC_isolate_pool_lock);
+  while (job.mj_finished < n_helpers)
+    pthread_cond_wait(&GC_isolate_pool_done_cond, &GC_isolate_pool_lock);
+  for (link = &GC_isolate_pool_jobs; *link != &job;
+       link = &(*link) -> mj_next) {
+    /* empty */
+  }
+  *link = job.mj_next;
+  pthread_mutex_unlock(&GC_isolate_pool_lock);
+  GC_isolate_helpers_running = FALSE;
+
+  GC_ASSERT(0 == job.mj_owner_n);
+  for (i = 0; i < job.mj_n_markers; i++) {
+    GC_ASSERT(job.mj_markers[i].md_top == job.mj_markers[i].md_bottom);
+    free(job.mj_markers[i].md_entries);
+    pthread_mutex_destroy(&job.mj_markers[i].md_lock);
+  }
+  free(job.mj_markers);
+  free(job.mj_owner_entries);
+  pthread_mutex_destroy(&job.mj_owner_lock);
+  return TRUE;
+}
+#endif /* ISOLATE_PARALLEL_MARK */
+
+#ifdef GC_THREAD_ISOLATE
+  GC_API void GC_CALL GC_set_isolate_mark_threads(int n)
+  {
+    GC_ASSERT(n >= 0);
+#   ifdef ISOLATE_PARALLEL_MARK
+      GC_isolate_mark_threads = n < ISOLATE_MAX_MARK_THREADS ? n
+                                        : ISOLATE_MAX_MARK_THREADS;
+#   else
+      (void)n;
+#   endif
+  }
+
+  GC_API int GC_CALL GC_get_isolate_mark_threads(void)
+  {
+#   ifdef ISOLATE_PARALLEL_MARK
+      return GC_isolate_mark_threads;
+#   else
+      return 0;
+#   endif
+  }
+#endif /* GC_THREAD_ISOLATE */
+
 #ifdef ESCARGOT
 GC_API mse * GC_mark_and_push_custom_iterable(GC_word *addr, mse *mark_stack_ptr, mse *mark_stack_limit,
                                      GC_get_next_pointer_proc proc) {
@@ -956,6 +1741,67 @@ GC_API mse * GC_mark_and_push_custom(GC_word *addr, mse *mark_stack_ptr, mse *ma
     return (mark_stack_ptr);
 }
 
+#ifndef CUSTOM_SPANS_SZ
+# define CUSTOM_SPANS_SZ 32     /* Spans asked of the client at once.   */
+#endif
+#ifndef CUSTOM_SPAN_INLINE_WORDS
+# define CUSTOM_SPAN_INLINE_WORDS 8
+                /* Longer spans are pushed as ranges, and scanned by    */
+                /* GC_mark_from, rather than scanned here.              */
+#endif
+
+GC_API mse * GC_mark_and_push_custom_spans(GC_word *addr, mse *mark_stack_ptr,
+                                           mse *mark_stack_limit,
+                                           GC_get_pointer_spans_proc proc) {
+    struct GC_mark_span spans[CUSTOM_SPANS_SZ];
+    ptr_t greatest_ha = (ptr_t)GC_greatest_plausible_heap_addr;
+    ptr_t least_ha = (ptr_t)GC_least_plausible_heap_addr;
+    GC_word *iterator = (GC_word *)GC_USR_PTR_FROM_BASE(addr);
+    GC_word *end = (GC_word *)((char *)addr + GC_size(addr));
+    GC_word *next_ptr;
+    DECLARE_HDR_CACHE;
+
+    INIT_HDR_CACHE;
+    while ((word)iterator < (word)end) {
+        size_t n = proc(iterator, end, &next_ptr, spans, CUSTOM_SPANS_SZ);
+        size_t i;
+
+        GC_ASSERT(n <= CUSTOM_SPANS_SZ);
+        for (i = 0; i < n; i++) {
+            GC_word *current_p = spans[i].from;
+            GC_word *limit = spans[i].to;
+
+            GC_ASSERT((word)current_p <= (word)limit);
+            if ((word)(limit - current_p) > CUSTOM_SPAN_INLINE_WORDS) {
+                mark_stack_ptr++;
+                if ((word)mark_stack_ptr >= (word)mark_stack_limit) {
+                    mark_stack_ptr =
+                                GC_signal_mark_stack_overflow(mark_stack_ptr);
+                }
+                mark_stack_ptr -> mse_start = (ptr_t)current_p;
+                mark_stack_ptr -> mse_descr.w =
+                                        (word)limit - (word)current_p;
+                continue;
+            }
+            for (; (word)current_p < (word)limit; current_p++) {
+                word current = *current_p;
+
+                FIXUP_POINTER(current);
+                if (current >= (word)least_ha && current < (word)greatest_ha) {
+                    PUSH_CONTENTS((ptr_t)current, mark_stack_ptr,
+                                  mark_stack_limit, (ptr_t)current_p);
+                }
+            }
+        }
+        /* A procedure which does not advance would loop forever.      */
+        GC_ASSERT((word)next_ptr > (word)iterator);
+        if (EXPECT((word)next_ptr <= (word)iterator, FALSE))
+            break;
+        iterator = next_ptr;
+    }
+    return (mark_stack_ptr);
+}
+
 #endif
 
 
@@ -1648,19 +2494,82 @@ GC_API void GC_CALL GC_push_all_eager(void *bottom, void *top)
     /* check all pointers in range and push if they appear      */
     /* to be valid.                                             */
       lim = t - 1 /* longword */;
-      for (p = b; (word)p <= (word)lim;
-           p = (word *)(((ptr_t)p) + ALIGNMENT)) {
-        REGISTER word q = *p;
+      p = b;
+#     ifdef VECTOR_SCAN
+        /* Filter VECTOR_SCAN_WORDS words at once, then drop the values */
+        /* which are between the heap sections without looking up the  */
+        /* header (but black-list them as GC_mark_and_push_stack does). */
+        if ((word)greatest_ha > (word)least_ha) {
+          word span = (word)greatest_ha - (word)least_ha;
+          ptr_t map_base = GC_heap_map_base;
+          unsigned map_shift = GC_heap_map_shift;
+
+          for (; (word)(p + VECTOR_SCAN_WORDS - 1) <= (word)lim;
+               p += VECTOR_SCAN_WORDS) {
+            unsigned mask = GC_plausible_mask(p, (word)least_ha, span);
+
+            while (mask != 0) {
+              word *src = p + __builtin_ctz(mask);
+              REGISTER word q = *src;
+
+              mask &= mask - 1;
+              if (IN_HEAP_MAP(q, map_base, map_shift)) {
+                PUSH_ONE_CHECKED_STACK(q, src);
+              } else {
+                GC_ADD_TO_BLACK_LIST_STACK(q, (ptr_t)src);
+              }
+            }
+          }
+        }
+#     endif
+#     if defined(HEAP_MAP) && !defined(NEED_FIXUP_POINTER)
+        {
+          ptr_t map_base = GC_heap_map_base;
+          unsigned map_shift = GC_heap_map_shift;
+
+          for (; (word)p <= (word)lim;
+               p = (word *)(((ptr_t)p) + ALIGNMENT)) {
+            REGISTER word q = *p;
+
+            if (IN_HEAP_MAP(q, map_base, map_shift)) {
+              PUSH_ONE_CHECKED_STACK(q, p);
+            } else if ((word)q >= (word)least_ha
+                       && (word)q < (word)greatest_ha) {
+              GC_ADD_TO_BLACK_LIST_STACK(q, (ptr_t)p);
+            }
+          }
+        }
+#     else
+        for (; (word)p <= (word)lim;
+             p = (word *)(((ptr_t)p) + ALIGNMENT)) {
+          REGISTER word q = *p;
 
-        GC_PUSH_ONE_STACK(q, p);
+          GC_PUSH_ONE_STACK(q, p);
+        }
+#     endif
+#   ifdef GC_COMPRESSED_POINTERS
+      {
+        /* The compressed pointers loaded from the objects may be kept */
+        /* in either half of a word.  The heap starts high in the      */
+        /* window, so the small integers (and NULL) are below it.      */
+        unsigned *h = (unsigned *)b;
+        unsigned *hlim = (unsigned *)t - 1;
+        ptr_t base = GC_compressed_base;
+
+        for (; (word)h <= (word)hlim; h++) {
+          REGISTER word q = (word)(base + *h);
+
+          GC_PUSH_ONE_STACK(q, (ptr_t)h);
+        }
       }
+#   endif
 #   undef GC_greatest_plausible_heap_addr
 #   undef GC_least_plausible_heap_addr
 }
 
 GC_INNER void GC_push_all_stack(ptr_t bottom, ptr_t top)
 {
-#   ifndef NEED_FIXUP_POINTER
+#   if !defined(NEED_FIXUP_POINTER) && !defined(GC_COMPRESSED_POINTERS)
       if (GC_all_interior_pointers
 #         if defined(THREADS) && defined(MPROTECT_VDB)
             && !GC_auto_incremental
@@ -881,6 +881,21 @@ GC_API void GC_CALL GC_register_mark_stack_func(GC_mark_stack_func func)
 {
         GC_mark_stack_func_proc = func;
 }
+
+STATIC void GC_push_stack_below_inner(ptr_t boundary,
+                                      void * context GC_ATTR_UNUSED)
+{
+#   ifdef STACK_GROWS_DOWN
+      GC_push_all_eager(GC_approx_sp(), boundary);
+#   else
+      GC_push_all_eager(boundary, GC_approx_sp());
+#   endif
+}
+
+GC_API void GC_CALL GC_push_stack_below(void *boundary)
+{
+    GC_with_callee_saves_pushed(GC_push_stack_below_inner, (ptr_t)boundary);
+}
 #endif
 /*
  * Call the mark routines (GC_push_one for a single pointer,
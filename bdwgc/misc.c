@@ -1295,6 +1295,15 @@ GC_API void GC_CALL GC_init(void)
           GC_set_max_heap_size(max_heap_sz);
         }
     }
+#   ifdef HEAP_RESERVE
+      {
+        char * sz_str = GETENV("GC_HEAP_RESERVE");
+        if (sz_str != NULL) {
+          GC_set_heap_reserve(GC_parse_mem_size_arg(sz_str));
+        }
+      }
+      GC_init_heap_reserve();
+#   endif
 #   if defined(GC_ASSERTIONS) && defined(GC_ALWAYS_MULTITHREADED)
         LOCK(); /* just to set GC_lock_holder */
 #   endif
@@ -1463,6 +1472,13 @@ GC_API void GC_CALL GC_enable_incremental(void)
   GC_API void GC_CALL GC_deinit(void)
   {
     if (GC_is_initialized) {
+#     ifdef BACKGROUND_SWEEP
+        DCL_LOCK_STATE;
+
+        LOCK();
+        GC_finish_background_sweep();
+        UNLOCK();
+#     endif
       /* Prevent duplicate resource close.  */
       GC_is_initialized = FALSE;
 #     if defined(THREADS) && (defined(MSWIN32) || defined(MSWINCE))
@@ -2271,6 +2271,36 @@ void GC_register_data_segments(void)
   }
 # endif  /* !MSWIN_XBOX1 */
 
+# ifdef FLAT_TL
+    GC_INNER ptr_t GC_get_lazy_mem(size_t bytes)
+    {
+      void *result = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                          -1, 0/* offset */);
+
+      return MAP_FAILED == result ? NULL : (ptr_t)result;
+    }
+# endif
+
+# ifdef HEAP_RESERVE
+    GC_INNER ptr_t GC_reserve_mem(size_t bytes)
+    {
+      /* Inaccessible pages are not accounted as committed memory until */
+      /* they are made writable by GC_commit_mem.                       */
+      void *result = mmap(NULL, bytes, PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0/* offset */);
+
+      return MAP_FAILED == result ? NULL : (ptr_t)result;
+    }
+
+    GC_INNER GC_bool GC_commit_mem(ptr_t start, size_t bytes)
+    {
+      return mprotect(start, bytes, (PROT_READ | PROT_WRITE)
+                                    | (GC_pages_executable ? PROT_EXEC : 0))
+             == 0;
+    }
+# endif
+
 #endif  /* MMAP_SUPPORTED */
 
 #if defined(USE_MMAP)
@@ -2901,7 +2931,7 @@ GC_API GC_push_other_roots_proc GC_CALL GC_get_push_other_roots(void)
 
 /*
  * Routines for accessing dirty bits on virtual pages.
- * There are six ways to maintain this information:
+ * There are eight ways to maintain this information:
  * DEFAULT_VDB: A simple dummy implementation that treats every page
  *              as possibly dirty.  This makes incremental collection
  *              useless, but the implementation is still correct.
@@ -2937,16 +2967,28 @@ GC_API GC_push_other_roots_proc GC_CALL GC_get_push_other_roots(void)
  *              read dirty bits.  In case it is not available (because we
  *              are running on Windows 95, Windows 2000 or earlier),
  *              MPROTECT_VDB may be defined as a fallback strategy.
+ * SOFT_VDB:    Use the Linux soft-dirty bits, if available, to read dirty
+ *              bits of all the heap pages in bulk, with neither signals
+ *              nor page protection changes.  MPROTECT_VDB is the fallback
+ *              strategy (for kernels without soft-dirty bits support).
+ * UFFD_VDB:    Write-protect the heap sections by a Linux userfaultfd in
+ *              the asynchronous mode, and collect the written pages of
+ *              each section by one PAGEMAP_SCAN request, again with
+ *              neither signals nor page protection changes.  Preferred
+ *              to SOFT_VDB (which is the fallback along with
+ *              MPROTECT_VDB) since it affects only the heap sections.
  */
 
-#if (defined(CHECKSUMS) && defined(GWW_VDB)) || defined(PROC_VDB)
+#if (defined(CHECKSUMS) && (defined(GWW_VDB) || defined(UFFD_VDB) \
+                           || defined(SOFT_VDB))) \
+    || defined(PROC_VDB)
     /* Add all pages in pht2 to pht1.   */
     STATIC void GC_or_pages(page_hash_table pht1, page_hash_table pht2)
     {
       unsigned i;
       for (i = 0; i < PHT_SIZE; i++) pht1[i] |= pht2[i];
     }
-#endif /* CHECKSUMS && GWW_VDB || PROC_VDB */
+#endif /* CHECKSUMS && (GWW_VDB || UFFD_VDB || SOFT_VDB) || PROC_VDB */
 
 #ifdef GWW_VDB
 
@@ -3041,9 +3083,432 @@ GC_API GC_push_other_roots_proc GC_CALL GC_get_push_other_roots(void)
       GC_or_pages(GC_written_pages, GC_grungy_pages);
 #   endif
   }
-#else
+#endif /* GWW_VDB */
+
+#ifdef UFFD_VDB
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+
+  /* A userfaultfd with the write-protect mode registered in the async  */
+  /* mode (Linux 6.7+) lets the kernel resolve the write faults itself  */
+  /* (no signal, no user thread is involved), just noting the page is  */
+  /* written.  The PAGEMAP_SCAN ioctl of /proc/self/pagemap reports the */
+  /* written pages of a range and write-protects them again, at once.   */
+  /* Unlike clearing the soft-dirty bits, this affects only the given   */
+  /* range, thus it is usable with several isolated heaps too.  The ABI */
+  /* is declared here as the system headers may predate it.             */
+  typedef unsigned long long GC_uffd_u64;
+
+  struct GC_uffdio_range { GC_uffd_u64 start, len; };
+  struct GC_uffdio_api { GC_uffd_u64 api, features, ioctls; };
+  struct GC_uffdio_register {
+    struct GC_uffdio_range range;
+    GC_uffd_u64 mode, ioctls;
+  };
+  struct GC_uffdio_writeprotect {
+    struct GC_uffdio_range range;
+    GC_uffd_u64 mode;
+  };
+
+# define GC_UFFD_USER_MODE_ONLY 1
+# define GC_UFFD_API ((GC_uffd_u64)0xAA)
+# define GC_UFFD_FEATURE_WP_UNPOPULATED ((GC_uffd_u64)1 << 13)
+# define GC_UFFD_FEATURE_WP_ASYNC ((GC_uffd_u64)1 << 15)
+# define GC_UFFDIO_REGISTER_MODE_WP ((GC_uffd_u64)1 << 1)
+# define GC_UFFDIO_WRITEPROTECT_MODE_WP ((GC_uffd_u64)1 << 0)
+# define GC_UFFDIO_REGISTER _IOWR(0xAA, 0x00, struct GC_uffdio_register)
+# define GC_UFFDIO_WRITEPROTECT \
+                _IOWR(0xAA, 0x06, struct GC_uffdio_writeprotect)
+# define GC_UFFDIO_API _IOWR(0xAA, 0x3F, struct GC_uffdio_api)
+
+  struct GC_page_region { GC_uffd_u64 start, end, categories; };
+  struct GC_pm_scan_arg {
+    GC_uffd_u64 size, flags, start, end, walk_end, vec, vec_len, max_pages;
+    GC_uffd_u64 category_inverted, category_mask, category_anyof_mask;
+    GC_uffd_u64 return_mask;
+  };
+
+# define GC_PAGE_IS_WRITTEN ((GC_uffd_u64)1 << 1)
+# define GC_PM_SCAN_WP_MATCHING ((GC_uffd_u64)1 << 0)
+# define GC_PM_SCAN_CHECK_WPASYNC ((GC_uffd_u64)1 << 1)
+# define GC_PAGEMAP_SCAN _IOWR('f', 16, struct GC_pm_scan_arg)
+
+# define GC_UFFD_VEC_LEN 64     /* Written regions reported at once.    */
+
+  /* Both descriptors are shared by all the heaps (the registrations   */
+  /* and the scans are per address range), and are never closed.        */
+  STATIC int GC_uffd_fd = -1;
+  STATIC int GC_uffd_pagemap_fd = -1;
+
+  /* The number of the leading entries of GC_heap_sects registered in   */
+  /* (and write-protected by) the userfaultfd.                          */
+  STATIC MAY_THREAD_LOCAL word GC_uffd_n_registered = 0;
+
+# define GC_UFFD_AVAILABLE() (GC_uffd_fd != -1)
+
+  /* Register the range in the userfaultfd (unless it is already) and   */
+  /* write-protect it.  Returns FALSE on failure.                       */
+  STATIC GC_bool GC_uffd_protect(int fd, ptr_t start, size_t len)
+  {
+    struct GC_uffdio_register reg;
+    struct GC_uffdio_writeprotect wp;
+
+    reg.range.start = (GC_uffd_u64)(word)start;
+    reg.range.len = (GC_uffd_u64)len;
+    reg.mode = GC_UFFDIO_REGISTER_MODE_WP;
+    reg.ioctls = 0;
+    if (ioctl(fd, GC_UFFDIO_REGISTER, &reg) == -1)
+      return FALSE;
+    wp.range = reg.range;
+    wp.mode = GC_UFFDIO_WRITEPROTECT_MODE_WP;
+    return ioctl(fd, GC_UFFDIO_WRITEPROTECT, &wp) != -1;
+  }
+
+  /* Report the regions of [start, end) written since the previous scan */
+  /* (or the registration) and write-protect them again.  Returns the   */
+  /* number of regions stored to vec, or -1 (e.g. if a part of range is */
+  /* not registered).  *pwalk_end is set to where the scan stopped.     */
+  STATIC int GC_uffd_scan(int pagemap_fd, ptr_t start, ptr_t end,
+                          struct GC_page_region *vec, ptr_t *pwalk_end)
+  {
+    struct GC_pm_scan_arg arg;
+    int res;
+
+    BZERO(&arg, sizeof(arg));
+    arg.size = sizeof(arg);
+    arg.flags = GC_PM_SCAN_WP_MATCHING | GC_PM_SCAN_CHECK_WPASYNC;
+    arg.start = (GC_uffd_u64)(word)start;
+    arg.end = (GC_uffd_u64)(word)end;
+    arg.vec = (GC_uffd_u64)(word)vec;
+    arg.vec_len = GC_UFFD_VEC_LEN;
+    arg.category_mask = GC_PAGE_IS_WRITTEN;
+    arg.return_mask = GC_PAGE_IS_WRITTEN;
+    res = ioctl(pagemap_fd, GC_PAGEMAP_SCAN, &arg);
+    *pwalk_end = (ptr_t)(word)arg.walk_end;
+    return res;
+  }
+
+  /* Check the whole protocol on a fresh mapping, in particular that    */
+  /* PAGEMAP_SCAN is implemented (it appeared after the async mode).    */
+  STATIC GC_bool GC_uffd_works(int fd, int pagemap_fd)
+  {
+    struct GC_page_region vec[GC_UFFD_VEC_LEN];
+    ptr_t walk_end;
+    size_t len = 2 * GC_page_size;
+    ptr_t p = (ptr_t)mmap(NULL, len, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    GC_bool ok;
+
+    if (MAP_FAILED == (void *)p)
+      return FALSE;
+    ok = GC_uffd_protect(fd, p, len)
+         && GC_uffd_scan(pagemap_fd, p, p + len, vec, &walk_end) == 0;
+    if (ok) {
+      *(volatile char *)(p + GC_page_size) = 1;
+      ok = GC_uffd_scan(pagemap_fd, p, p + len, vec, &walk_end) == 1
+           && vec[0].start == (GC_uffd_u64)(word)(p + GC_page_size)
+           && vec[0].end == (GC_uffd_u64)(word)(p + len)
+           && GC_uffd_scan(pagemap_fd, p, p + len, vec, &walk_end) == 0;
+    }
+    (void)munmap(p, len); /* drops the registration as well */
+    return ok;
+  }
+
+  /* Returns TRUE if the userfaultfd write-protection in the async mode */
+  /* is usable.  May be called repeatedly.                              */
+  STATIC GC_bool GC_uffd_dirty_init(void)
+  {
+    char * str = GETENV("GC_USE_USERFAULTFD");
+    struct GC_uffdio_api api;
+    int fd, pagemap_fd;
+
+    if (GC_uffd_fd != -1)
+      return TRUE;
+    if (str != NULL && *str == '0' && *(str + 1) == '\0') {
+      /* GC_USE_USERFAULTFD is set "0".  Fall back to the others.       */
+      return FALSE;
+    }
+    /* The faults are never delivered to the descriptor, so there is    */
+    /* no need to handle kernel-mode faults (which would require a     */
+    /* privilege).                                                      */
+    fd = (int)syscall(__NR_userfaultfd,
+                      O_CLOEXEC | O_NONBLOCK | GC_UFFD_USER_MODE_ONLY);
+    if (-1 == fd) {
+      GC_COND_LOG_PRINTF("userfaultfd is not available\n");
+      return FALSE;
+    }
+    api.api = GC_UFFD_API;
+    api.features = GC_UFFD_FEATURE_WP_ASYNC | GC_UFFD_FEATURE_WP_UNPOPULATED;
+    api.ioctls = 0;
+    pagemap_fd = -1;
+    if (ioctl(fd, GC_UFFDIO_API, &api) != -1)
+      pagemap_fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if (pagemap_fd != -1 && GC_uffd_works(fd, pagemap_fd)) {
+      GC_uffd_pagemap_fd = pagemap_fd;
+      /* Another heap might have won the race (GC_uffd_pagemap_fd is    */
+      /* written before and read only after GC_uffd_fd is non-negative, */
+      /* and any of the pagemap descriptors is fine).                   */
+      if (!__sync_bool_compare_and_swap(&GC_uffd_fd, -1, fd))
+        (void)close(fd);
+      GC_VERBOSE_LOG_PRINTF(
+                "Initializing userfaultfd virtual dirty bit implementation\n");
+      return TRUE;
+    }
+    GC_COND_LOG_PRINTF("userfaultfd asynchronous write-protection"
+                       " is not supported\n");
+    if (pagemap_fd != -1)
+      (void)close(pagemap_fd);
+    (void)close(fd);
+    return FALSE;
+  }
+
+  GC_INLINE void GC_uffd_set_grungy_pages(ptr_t start, ptr_t end)
+  {
+    struct hblk * h = (struct hblk *)start;
+
+    for (; (word)h < (word)end; h++)
+      set_pht_entry_from_index(GC_grungy_pages, PHT_HASH(h));
+  }
+
+  GC_INLINE void GC_uffd_read_dirty(GC_bool output_unneeded)
+  {
+    struct GC_page_region vec[GC_UFFD_VEC_LEN];
+    word i;
+
+    if (!output_unneeded)
+      BZERO(GC_grungy_pages, sizeof(GC_grungy_pages));
+    for (i = 0; i != GC_n_heap_sects; ++i) {
+      ptr_t start = GC_heap_sects[i].hs_start;
+      ptr_t end = start + GC_heap_sects[i].hs_bytes;
+      GC_bool failed = FALSE;
+
+      if (i >= GC_uffd_n_registered) {
+        /* A new section: nothing is known about the writes to it yet.  */
+        failed = TRUE;
+      } else {
+        ptr_t p = start;
+
+        while ((word)p < (word)end) {
+          ptr_t walk_end;
+          int j, n = GC_uffd_scan(GC_uffd_pagemap_fd, p, end, vec,
+                                  &walk_end);
+
+          if (n < 0 || (word)walk_end <= (word)p) {
+            failed = TRUE;
+            break;
+          }
+          if (!output_unneeded) {
+            for (j = 0; j < n; j++)
+              GC_uffd_set_grungy_pages((ptr_t)(word)vec[j].start,
+                                       (ptr_t)(word)vec[j].end);
+          }
+          p = walk_end;
+        }
+      }
+      if (failed) {
+        /* Either the section is not registered yet, or a part of it    */
+        /* was remapped (e.g. by GC_unmap, which creates a new mapping  */
+        /* losing the registration).  Treat all its pages as dirty and  */
+        /* (re-)register it.                                            */
+        if (!output_unneeded)
+          GC_uffd_set_grungy_pages(start, end);
+        if (!GC_uffd_protect(GC_uffd_fd, start, end - start)) {
+          static GC_bool warned = FALSE;
+
+          if (!warned) {
+            /* The section stays dirty, which is correct but slow.      */
+            warned = TRUE;
+            WARN("Cannot write-protect heap section at %p"
+                 " by userfaultfd\n", start);
+          }
+        }
+      }
+    }
+    GC_uffd_n_registered = GC_n_heap_sects;
+#   ifdef CHECKSUMS
+      GC_ASSERT(!output_unneeded);
+      GC_or_pages(GC_written_pages, GC_grungy_pages);
+#   endif
+  }
+#endif /* UFFD_VDB */
+
+#ifdef SOFT_VDB
+  /* Writing "4" to /proc/self/clear_refs clears the soft-dirty bits of */
+  /* all the pages of the process; the kernel sets the bit of a page    */
+  /* again on the first write to it (handling the fault itself, without */
+  /* a signal).  The bits are read from /proc/self/pagemap, which has a */
+  /* 64-bit entry per page.  A page which is not present (e.g. never    */
+  /* touched) has no soft-dirty bit, and pages of a new mapping (e.g.   */
+  /* a remapped block) are reported as soft-dirty.                      */
+  typedef unsigned long long pagemap_elem_t;
+
+# define PM_SOFTDIRTY_MASK ((pagemap_elem_t)1 << 55)
+
+# define GC_SOFT_VDB_BUF_LEN 4096       /* Pagemap entries read at once. */
+  static pagemap_elem_t soft_vdb_buf[GC_SOFT_VDB_BUF_LEN];
+
+  STATIC int GC_clear_refs_fd = -1;
+  STATIC int GC_pagemap_fd = -1;
+
+# define GC_SOFT_AVAILABLE() (GC_clear_refs_fd != -1)
+
+  STATIC void GC_clear_soft_dirty_bits(void)
+  {
+    static GC_bool warned = FALSE;
+
+    if (write(GC_clear_refs_fd, "4\n", 2) != 2 && !warned) {
+      /* All pages stay dirty, which is correct but slow.       */
+      warned = TRUE;
+      WARN("Cannot clear soft-dirty bits\n", 0);
+    }
+  }
+
+  /* Return 1 if the page containing p is soft-dirty, 0 if it is not,   */
+  /* -1 if its pagemap entry cannot be read.                            */
+  STATIC int GC_soft_page_dirty(ptr_t p)
+  {
+    pagemap_elem_t entry;
+    off_t fpos = (off_t)((word)p / GC_page_size)
+                 * (off_t)sizeof(pagemap_elem_t);
+
+    if (pread(GC_pagemap_fd, &entry, sizeof(entry), fpos)
+        != (ssize_t)sizeof(entry))
+      return -1;
+    return (entry & PM_SOFTDIRTY_MASK) != 0;
+  }
+
+  /* Check that the bits are really cleared and set (some kernels are   */
+  /* built without CONFIG_MEM_SOFT_DIRTY, or do not implement them      */
+  /* properly).  The page of soft_vdb_buf is used for the test.         */
+  STATIC GC_bool GC_soft_dirty_works(void)
+  {
+    volatile pagemap_elem_t *p = soft_vdb_buf;
+
+    *p = 1;
+    if (GC_soft_page_dirty((ptr_t)p) != 1)
+      return FALSE;
+    GC_clear_soft_dirty_bits();
+    if (GC_soft_page_dirty((ptr_t)p) != 0)
+      return FALSE;
+    *p = 0;
+    return GC_soft_page_dirty((ptr_t)p) == 1;
+  }
+
+  /* Returns TRUE if the soft-dirty bits are usable.  May be called     */
+  /* repeatedly.                                                        */
+  STATIC GC_bool GC_soft_dirty_init(void)
+  {
+    char * str = GETENV("GC_USE_SOFT_DIRTY");
+
+    if (GC_clear_refs_fd != -1)
+      return TRUE;
+    if (str != NULL && *str == '0' && *(str + 1) == '\0') {
+      /* GC_USE_SOFT_DIRTY is set "0".  Fall back to MPROTECT_VDB.      */
+      return FALSE;
+    }
+    GC_clear_refs_fd = open("/proc/self/clear_refs", O_WRONLY);
+    if (-1 == GC_clear_refs_fd)
+      return FALSE;
+    GC_pagemap_fd = open("/proc/self/pagemap", O_RDONLY);
+    if (GC_pagemap_fd != -1 && GC_soft_dirty_works()) {
+      if (fcntl(GC_clear_refs_fd, F_SETFD, FD_CLOEXEC) == -1
+          || fcntl(GC_pagemap_fd, F_SETFD, FD_CLOEXEC) == -1)
+        WARN("Could not set FD_CLOEXEC for /proc\n", 0);
+      GC_VERBOSE_LOG_PRINTF(
+                "Initializing soft-dirty virtual dirty bit implementation\n");
+      return TRUE;
+    }
+    GC_COND_LOG_PRINTF("Soft-dirty bits are not supported\n");
+    if (GC_pagemap_fd != -1)
+      (void)close(GC_pagemap_fd);
+    (void)close(GC_clear_refs_fd);
+    GC_pagemap_fd = -1;
+    GC_clear_refs_fd = -1;
+    return FALSE;
+  }
+
+  GC_INLINE void GC_soft_set_grungy_page(word page)
+  {
+    struct hblk * h = (struct hblk *)(page * GC_page_size);
+    struct hblk * h_end = (struct hblk *)((page + 1) * GC_page_size);
+
+    do {
+      set_pht_entry_from_index(GC_grungy_pages, PHT_HASH(h));
+    } while ((word)(++h) < (word)h_end);
+  }
+
+  /* Set the entries of GC_grungy_pages of the soft-dirty pages         */
+  /* overlapping the given heap section.                                */
+  STATIC void GC_soft_set_grungy_pages(ptr_t start, size_t len)
+  {
+    word page = (word)start / GC_page_size;
+    word limit = ((word)start + len + GC_page_size - 1) / GC_page_size;
+
+    while (page < limit) {
+      word n = limit - page < GC_SOFT_VDB_BUF_LEN ? limit - page
+                                                  : GC_SOFT_VDB_BUF_LEN;
+      ssize_t res = pread(GC_pagemap_fd, soft_vdb_buf,
+                          n * sizeof(pagemap_elem_t),
+                          (off_t)page * (off_t)sizeof(pagemap_elem_t));
+      word i;
+
+      if (res < (ssize_t)sizeof(pagemap_elem_t)) {
+        static GC_bool warned = FALSE;
+
+        if (!warned) {
+          warned = TRUE;
+          WARN("Cannot read soft-dirty bits at %p:"
+               " treating the pages as dirty\n",
+               (ptr_t)(page * GC_page_size));
+        }
+        for (; page < limit; page++)
+          GC_soft_set_grungy_page(page);
+        break;
+      }
+      n = (word)res / sizeof(pagemap_elem_t);
+      for (i = 0; i < n; i++) {
+        if ((soft_vdb_buf[i] & PM_SOFTDIRTY_MASK) != 0)
+          GC_soft_set_grungy_page(page + i);
+      }
+      page += n;
+    }
+  }
+
+  GC_INLINE void GC_soft_read_dirty(GC_bool output_unneeded)
+  {
+    if (!output_unneeded) {
+      word i;
+
+      BZERO(GC_grungy_pages, sizeof(GC_grungy_pages));
+      for (i = 0; i != GC_n_heap_sects; ++i)
+        GC_soft_set_grungy_pages(GC_heap_sects[i].hs_start,
+                                 GC_heap_sects[i].hs_bytes);
+    }
+#   ifdef CHECKSUMS
+      GC_ASSERT(!output_unneeded);
+      GC_or_pages(GC_written_pages, GC_grungy_pages);
+#   endif
+    /* Nothing may be written to the heap in between (the world is      */
+    /* stopped).                                                        */
+    GC_clear_soft_dirty_bits();
+  }
+#endif /* SOFT_VDB */
+
+#if defined(UFFD_VDB) || defined(SOFT_VDB)
+  /* The dirty bits are read from the kernel rather than maintained by  */
+  /* MPROTECT_VDB.  At most one of the two is enabled.                  */
+# ifndef UFFD_VDB
+#   define GC_UFFD_AVAILABLE() FALSE
+#   define GC_uffd_read_dirty(output_unneeded) (void)(output_unneeded)
+# endif
+# ifndef SOFT_VDB
+#   define GC_SOFT_AVAILABLE() FALSE
+#   define GC_soft_read_dirty(output_unneeded) (void)(output_unneeded)
+# endif
+# define GC_GWW_AVAILABLE() (GC_UFFD_AVAILABLE() || GC_SOFT_AVAILABLE())
+#elif !defined(GWW_VDB)
 # define GC_GWW_AVAILABLE() FALSE
-#endif /* !GWW_VDB */
+#endif
 
 #ifdef DEFAULT_VDB
   /* All of the following assume the allocation lock is held.   */
@@ -3395,6 +3860,16 @@ GC_API GC_push_other_roots_proc GC_CALL GC_get_push_other_roots(void)
   /* during GC_init or GC_enable_incremental.                       */
   GC_INNER GC_bool GC_dirty_init(void)
   {
+#   ifdef UFFD_VDB
+      /* The remapped sections are just registered again.       */
+      if (GC_uffd_dirty_init())
+        return TRUE;
+#   endif
+#   ifdef SOFT_VDB
+      /* Unmapped memory is no problem for soft-dirty bits.     */
+      if (GC_soft_dirty_init())
+        return TRUE;
+#   endif
     if (GC_unmap_threshold != 0) {
       if (GETENV("GC_UNMAP_THRESHOLD") != NULL
           || GETENV("GC_FORCE_UNMAP_ON_GCOLLECT") != NULL
@@ -3418,6 +3893,17 @@ GC_API GC_push_other_roots_proc GC_CALL GC_get_push_other_roots(void)
   {
 #   if !defined(MSWIN32) && !defined(MSWINCE)
       struct sigaction act, oldact;
+#   endif
+
+#   if defined(UFFD_VDB) && !defined(USE_MUNMAP)
+      if (GC_uffd_dirty_init())
+        return TRUE;
+#   endif
+#   if defined(SOFT_VDB) && !defined(USE_MUNMAP)
+      if (GC_soft_dirty_init())
+        return TRUE;
+#   endif
+#   if !defined(MSWIN32) && !defined(MSWINCE)
       act.sa_flags = SA_RESTART | SA_SIGINFO;
       act.sa_sigaction = GC_write_fault_handler;
       (void)sigemptyset(&act.sa_mask);
@@ -3508,6 +3994,10 @@ GC_API int GC_CALL GC_incremental_protection_needs(void)
 {
     GC_ASSERT(GC_is_initialized);
 
+#   if defined(UFFD_VDB) || defined(SOFT_VDB)
+      if (GC_GWW_AVAILABLE())
+        return GC_PROTECTS_NONE;
+#   endif
     if (GC_page_size == HBLKSIZE) {
         return GC_PROTECTS_POINTER_HEAP;
     } else {
@@ -3781,6 +4271,13 @@ GC_INNER GC_bool GC_dirty_init(void)
 }
 #endif /* PCR_VDB */
 
+/* Receives the card marks until the card table of the heap is         */
+/* allocated (or forever, if the manual VDB mode is not on).  Shared,   */
+/* never read.                                                          */
+STATIC unsigned char GC_card_table_sink[GC_CARD_TABLE_ENTRIES];
+
+MAY_THREAD_LOCAL unsigned char *GC_card_table = GC_card_table_sink;
+
 #ifndef GC_DISABLE_INCREMENTAL
   GC_INNER MAY_THREAD_LOCAL GC_bool GC_manual_vdb = FALSE;
 
@@ -3798,6 +4295,51 @@ GC_INNER GC_bool GC_dirty_init(void)
     async_set_pht_entry_from_index(GC_dirty_pages, index);
   }
 
+  /* Add the blocks of the heap sections whose cards are marked to      */
+  /* GC_grungy_pages (unless output_unneeded), and clear the cards.     */
+  /* The table is allocated by the first call: the stores preceding the */
+  /* first retrieval of the dirty bits do not matter.                   */
+  STATIC void GC_read_card_table(GC_bool output_unneeded)
+  {
+    word i;
+
+    if (GC_card_table == GC_card_table_sink) {
+      unsigned char *table =
+                (unsigned char *)GC_scratch_alloc(GC_CARD_TABLE_ENTRIES);
+
+      if (NULL == table) {
+        /* Try again next time; the stores are lost meanwhile.          */
+        if (!output_unneeded)
+          memset(GC_grungy_pages, 0xff, sizeof(GC_grungy_pages));
+        WARN("Out of memory for card table\n", 0);
+        return;
+      }
+      BZERO(table, GC_CARD_TABLE_ENTRIES);
+      GC_card_table = table;
+      return;
+    }
+    if (!output_unneeded) {
+      for (i = 0; i < GC_n_heap_sects; i++) {
+        struct hblk *h = (struct hblk *)GC_heap_sects[i].hs_start;
+        struct hblk *h_end = (struct hblk *)(GC_heap_sects[i].hs_start
+                                             + GC_heap_sects[i].hs_bytes);
+
+        for (; (word)h < (word)h_end; h++) {
+          ptr_t p;
+
+          /* Look at every card overlapping the block.  */
+          for (p = (ptr_t)h; (word)p < (word)(h + 1); p += GC_CARD_BYTES) {
+            if (GC_card_table[GC_CARD_INDEX(p)] != 0) {
+              set_pht_entry_from_index(GC_grungy_pages, PHT_HASH(h));
+              break;
+            }
+          }
+        }
+      }
+    }
+    BZERO(GC_card_table, GC_CARD_TABLE_ENTRIES);
+  }
+
   /* Retrieve system dirty bits for the heap to a local buffer (unless  */
   /* output_unneeded).  Restore the systems notion of which pages are   */
   /* dirty.  We assume that either the world is stopped or it is OK to  */
@@ -3814,6 +4356,8 @@ GC_INNER GC_bool GC_dirty_init(void)
               sizeof(GC_dirty_pages));
       BZERO((/* no volatile */ void *)GC_dirty_pages,
             sizeof(GC_dirty_pages));
+      if (GC_manual_vdb)
+        GC_read_card_table(output_unneeded);
 #     ifdef MPROTECT_VDB
         if (!GC_manual_vdb)
           GC_protect_heap();
@@ -3823,6 +4367,12 @@ GC_INNER GC_bool GC_dirty_init(void)
 
 #   ifdef GWW_VDB
       GC_gww_read_dirty(output_unneeded);
+#   elif defined(UFFD_VDB) || defined(SOFT_VDB)
+      if (GC_UFFD_AVAILABLE()) {
+        GC_uffd_read_dirty(output_unneeded);
+      } else {
+        GC_soft_read_dirty(output_unneeded);
+      }
 #   elif defined(PROC_VDB)
       GC_proc_read_dirty(output_unneeded);
 #   elif defined(PCR_VDB)
@@ -3869,7 +4419,8 @@ GC_INNER GC_bool GC_dirty_init(void)
     /* Could any valid GC heap pointer ever have been written to this page? */
     GC_INNER GC_bool GC_page_was_ever_dirty(struct hblk *h)
     {
-#     if defined(GWW_VDB) || defined(PROC_VDB)
+#     if defined(GWW_VDB) || defined(UFFD_VDB) || defined(SOFT_VDB) \
+         || defined(PROC_VDB)
 #       ifdef MPROTECT_VDB
           if (!GC_GWW_AVAILABLE())
             return TRUE;
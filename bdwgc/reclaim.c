@@ -27,6 +27,11 @@
 
 #include <stdio.h>
 
+#ifdef BACKGROUND_SWEEP
+# include <pthread.h>
+# include <sched.h>
+#endif
+
 GC_INNER MAY_THREAD_LOCAL signed_word GC_bytes_found = 0;
                         /* Number of bytes of memory reclaimed     */
                         /* minus the number of bytes originally    */
@@ -51,7 +56,9 @@ STATIC MAY_THREAD_LOCAL unsigned GC_n_leaked = 0;
 
 GC_INNER MAY_THREAD_LOCAL GC_bool GC_have_errors = FALSE;
 
-#if !defined(EAGER_SWEEP) && (defined(ENABLE_DISCLAIM) || defined(ESCARGOT))
+#if (!defined(EAGER_SWEEP) || defined(BACKGROUND_SWEEP) \
+     || defined(GC_PACER)) \
+    && (defined(ENABLE_DISCLAIM) || defined(ESCARGOT))
   STATIC void GC_reclaim_unconditionally_marked(void);
 #endif
 
@@ -145,6 +152,99 @@ STATIC GC_bool GC_block_nearly_full(hdr *hhdr, word sz)
     return hhdr -> hb_n_marks > HBLK_OBJS(sz) * 7 / 8;
 }
 
+#ifdef BITMAP_SWEEP
+# if CPP_WORDSZ == 64
+#   define WORD_CTZ(w) __builtin_ctzll((unsigned long long)(w))
+#   define WORD_CLZ(w) __builtin_clzll((unsigned long long)(w))
+# else
+#   define WORD_CTZ(w) __builtin_ctz((unsigned)(w))
+#   define WORD_CLZ(w) __builtin_clz((unsigned)(w))
+# endif
+
+/*
+ * Restore unmarked small objects in hbp of size sz to the object
+ * free list, clearing them if init.  Returns the new list.
+ * Rather than testing the mark bit of each object, take the unmarked
+ * ones out of each mark word with count-trailing-zeros, a run of
+ * adjacent ones at a time (which is cleared at once).  Words with
+ * all the objects marked are skipped.  Sz is in bytes.
+ */
+STATIC ptr_t GC_reclaim_bits(struct hblk *hbp, hdr *hhdr, word sz,
+                             GC_bool init, ptr_t list, signed_word *count)
+{
+    word gran = BYTES_TO_GRANULES(sz);
+    word limit = BYTES_TO_GRANULES(HBLKSIZE - sz) + 1;
+                        /* Past the bit of the last object.             */
+    word pattern = 1;   /* The object bits of a word starting with one. */
+    word carry;         /* The shift of pattern for the next word, ...  */
+    word shift = 0;     /* and for the current one.                     */
+    signed_word n_bytes_found = 0;
+    word i;
+
+#   ifndef BACKGROUND_SWEEP
+      GC_ASSERT(hhdr == GC_find_header((ptr_t)hbp));
+#   endif
+#   ifndef THREADS
+      GC_ASSERT(sz == hhdr -> hb_sz);
+#   endif
+    GC_ASSERT((sz & (BYTES_PER_WORD-1)) == 0);
+    GC_ASSERT(gran > 0 && limit <= FINAL_MARK_BIT(sz));
+    for (i = gran; i < WORDSZ; i <<= 1)
+      pattern |= pattern << i;
+    carry = (WORDSZ - 1 - (word)WORD_CLZ(pattern)) + gran - WORDSZ;
+    for (i = 0; i < divWORDSZ(limit + WORDSZ - 1); i++) {
+      word first = i * WORDSZ;
+      word objs, marked, unmarked;
+
+      if (shift >= WORDSZ) {
+        /* No object starts in this word.       */
+        shift -= WORDSZ;
+        continue;
+      }
+      objs = pattern << shift;
+      shift += carry;
+      if (shift >= gran) shift -= gran;
+      if (limit - first < WORDSZ)
+        objs &= ((word)1 << (limit - first)) - 1;
+      marked = objs & hhdr -> hb_marks[i];
+      unmarked = objs ^ marked;
+      while (unmarked != 0) {
+        word start = (word)WORD_CTZ(unmarked);
+        word above = marked >> start;
+        ptr_t p = hbp -> hb_body + GRANULES_TO_BYTES(first + start);
+        ptr_t end;
+
+        if (above != 0) {
+          /* The run ends at the next marked object.    */
+          word stop = start + (word)WORD_CTZ(above);
+
+          end = hbp -> hb_body + GRANULES_TO_BYTES(first + stop);
+          unmarked &= ~(((word)1 << stop) - 1);
+        } else {
+          /* The run takes the rest of the objects of the word. */
+          end = hbp -> hb_body + GRANULES_TO_BYTES(first + WORDSZ - 1
+                                        - (word)WORD_CLZ(objs)) + sz;
+          unmarked = 0;
+        }
+        n_bytes_found += end - p;
+        if (init)
+          BZERO(p, end - p);
+        for (; (word)p < (word)end; p += sz) {
+          obj_link(p) = list;
+          list = p;
+        }
+      }
+    }
+    *count += n_bytes_found;
+    return(list);
+}
+
+# define GC_reclaim_clear(hbp, hhdr, sz, list, count) \
+                GC_reclaim_bits(hbp, hhdr, sz, TRUE, list, count)
+# define GC_reclaim_uninit(hbp, hhdr, sz, list, count) \
+                GC_reclaim_bits(hbp, hhdr, sz, FALSE, list, count)
+
+#else
 /* TODO: This should perhaps again be specialized for USE_MARK_BYTES    */
 /* and USE_MARK_BITS cases.                                             */
 
@@ -160,7 +260,11 @@ STATIC ptr_t GC_reclaim_clear(struct hblk *hbp, hdr *hhdr, word sz,
     word *p, *q, *plim;
     signed_word n_bytes_found = 0;
 
-    GC_ASSERT(hhdr == GC_find_header((ptr_t)hbp));
+#   ifndef BACKGROUND_SWEEP
+      /* Otherwise checked by GC_reclaim_generic, as the background     */
+      /* sweeper cannot look up (thread-local) headers.                 */
+      GC_ASSERT(hhdr == GC_find_header((ptr_t)hbp));
+#   endif
 #   ifndef THREADS
       GC_ASSERT(sz == hhdr -> hb_sz);
 #   else
@@ -231,6 +335,7 @@ STATIC ptr_t GC_reclaim_uninit(struct hblk *hbp, hdr *hhdr, word sz,
     *count += n_bytes_found;
     return(list);
 }
+#endif /* !BITMAP_SWEEP */
 
 #ifdef ENABLE_DISCLAIM
   /* Call reclaim notifier for block's kind on each unmarked object in  */
@@ -319,6 +424,139 @@ STATIC void GC_reclaim_check(struct hblk *hbp, hdr *hhdr, word sz)
 # define IS_PTRFREE_SAFE(hhdr) ((hhdr)->hb_descr == 0)
 #endif
 
+#ifdef BACKGROUND_SWEEP
+/* Background sweeping.  At the end of a collection, the blocks of the  */
+/* reclaim lists are marked SWEEP_QUEUED and handed to a helper thread  */
+/* (shared by all heaps), while they stay on the reclaim lists.  Every  */
+/* block is claimed atomically, either by the sweeper (which builds     */
+/* the free list of the block aside, in hb_swept_list) or by the        */
+/* allocator (which sweeps it as usual).  When the allocator reaches a  */
+/* block which is swept, or is being swept, it waits for the sweeper    */
+/* to finish it and takes its free list, so it never sees a block in a  */
+/* half-swept state.  The sweeper only writes unmarked objects and the  */
+/* hb_sweep_state and hb_swept_* header fields, so it runs without the  */
+/* allocation lock.                                                     */
+
+# ifndef BACKGROUND_SWEEP_MIN_BLOCKS
+#   define BACKGROUND_SWEEP_MIN_BLOCKS 64
+                        /* Fewer blocks are swept in the pause. */
+# endif
+
+struct GC_sweep_item {
+  struct hblk *si_hbp;
+  hdr *si_hhdr;         /* Headers may not be looked up by the sweeper. */
+  word si_sz;
+  GC_bool si_init;
+};
+
+typedef struct GC_sweep_job_s {
+  struct GC_sweep_job_s *sj_next;
+  int sj_cancelled;     /* Read atomically by the sweeper.              */
+  GC_bool sj_running;
+  GC_bool sj_finished;
+  size_t sj_n_items;
+  struct GC_sweep_item sj_items[1];
+} GC_sweep_job;
+
+STATIC pthread_mutex_t GC_sweeper_lock = PTHREAD_MUTEX_INITIALIZER;
+STATIC pthread_cond_t GC_sweeper_cond = PTHREAD_COND_INITIALIZER;
+                                /* Signaled when a job is posted.       */
+STATIC pthread_cond_t GC_sweeper_done_cond = PTHREAD_COND_INITIALIZER;
+                                /* Signaled when a job is finished.     */
+STATIC GC_bool GC_sweeper_started = FALSE;
+STATIC GC_sweep_job *GC_sweep_jobs = NULL;
+                                /* Posted jobs, oldest first.           */
+
+STATIC MAY_THREAD_LOCAL int GC_background_sweep = 0;
+STATIC MAY_THREAD_LOCAL GC_sweep_job *GC_sweep_job_posted = NULL;
+                                /* The job of this heap, if any.        */
+
+STATIC void GC_sweep_in_background(struct GC_sweep_item *item)
+{
+  hdr *hhdr = item -> si_hhdr;
+  unsigned char state = SWEEP_QUEUED;
+  signed_word n_bytes_found = 0;
+  ptr_t list, tail;
+
+  if (!__atomic_compare_exchange_n(&hhdr -> hb_sweep_state, &state,
+                                   SWEEP_BUSY, FALSE, __ATOMIC_ACQUIRE,
+                                   __ATOMIC_RELAXED))
+    return; /* Taken by the allocator. */
+  if (item -> si_init) {
+    list = GC_reclaim_clear(item -> si_hbp, hhdr, item -> si_sz, NULL,
+                            &n_bytes_found);
+  } else {
+    list = GC_reclaim_uninit(item -> si_hbp, hhdr, item -> si_sz, NULL,
+                             &n_bytes_found);
+  }
+  /* Find the tail here, so the allocator can splice the list in O(1).  */
+  tail = list;
+  if (tail != NULL) {
+    while (obj_link(tail) != NULL)
+      tail = (ptr_t)obj_link(tail);
+  }
+  hhdr -> hb_swept_list = list;
+  hhdr -> hb_swept_tail = tail;
+  hhdr -> hb_swept_bytes = (word)n_bytes_found;
+  __atomic_store_n(&hhdr -> hb_sweep_state, SWEEP_DONE, __ATOMIC_RELEASE);
+}
+
+STATIC void *GC_sweeper_thread(void *arg GC_ATTR_UNUSED)
+{
+  pthread_mutex_lock(&GC_sweeper_lock);
+  for (;;) {
+    GC_sweep_job *job = GC_sweep_jobs;
+    size_t i;
+
+    if (NULL == job) {
+      pthread_cond_wait(&GC_sweeper_cond, &GC_sweeper_lock);
+      continue;
+    }
+    GC_sweep_jobs = job -> sj_next;
+    job -> sj_running = TRUE;
+    pthread_mutex_unlock(&GC_sweeper_lock);
+
+    for (i = 0; i < job -> sj_n_items; i++) {
+      if (__atomic_load_n(&job -> sj_cancelled, __ATOMIC_RELAXED))
+        break;
+      GC_sweep_in_background(job -> sj_items + i);
+    }
+
+    pthread_mutex_lock(&GC_sweeper_lock);
+    job -> sj_finished = TRUE;
+    pthread_cond_broadcast(&GC_sweeper_done_cond);
+  }
+  return NULL;
+}
+
+/* Called with the allocation lock held on a block whose state is not   */
+/* SWEEP_NONE.  Returns FALSE if the block is not swept yet; it is then */
+/* owned by the caller.  Otherwise, prepends the free objects found by  */
+/* the sweeper to *plist, and adds their size to *count.                */
+STATIC GC_bool GC_take_swept_block(hdr *hhdr, ptr_t *plist,
+                                   signed_word *count)
+{
+  unsigned char state = SWEEP_QUEUED;
+
+  if (__atomic_compare_exchange_n(&hhdr -> hb_sweep_state, &state,
+                                  SWEEP_NONE, FALSE, __ATOMIC_ACQUIRE,
+                                  __ATOMIC_ACQUIRE))
+    return FALSE;
+  while (SWEEP_BUSY == state) {
+    sched_yield();
+    state = __atomic_load_n(&hhdr -> hb_sweep_state, __ATOMIC_ACQUIRE);
+  }
+  GC_ASSERT(SWEEP_DONE == state);
+  if (hhdr -> hb_swept_list != NULL) {
+    obj_link(hhdr -> hb_swept_tail) = *plist;
+    *plist = hhdr -> hb_swept_list;
+  }
+  *count += (signed_word)hhdr -> hb_swept_bytes;
+  hhdr -> hb_sweep_state = SWEEP_NONE;
+  return TRUE;
+}
+#endif /* BACKGROUND_SWEEP */
+
 /*
  * Generic procedure to rebuild a free list in hbp.
  * Also called directly from GC_malloc_many.
@@ -331,6 +569,11 @@ GC_INNER ptr_t GC_reclaim_generic(struct hblk * hbp, hdr *hhdr, size_t sz,
     ptr_t result;
 
     GC_ASSERT(GC_find_header((ptr_t)hbp) == hhdr);
+#   ifdef BACKGROUND_SWEEP
+      if (__atomic_load_n(&hhdr -> hb_sweep_state, __ATOMIC_RELAXED)
+            != SWEEP_NONE && GC_take_swept_block(hhdr, &list, count))
+        return list;
+#   endif
 #   ifndef GC_DISABLE_INCREMENTAL
       GC_remove_protection(hbp, 1, IS_PTRFREE_SAFE(hhdr));
 #   endif
@@ -446,9 +689,19 @@ STATIC void GC_reclaim_block(struct hblk *hbp, word report_if_found)
             } else {
               GC_composite_in_use += sz;
             }
+#           ifdef ESCARGOT
+              GC_marked_objs++;
+              GC_blocks_in_use += OBJ_SZ_TO_BLOCKS(sz);
+              GC_block_bytes_in_use += OBJ_SZ_TO_BLOCKS(sz) * HBLKSIZE;
+#           endif
         }
     } else {
         GC_bool empty = GC_block_empty(hhdr);
+#       ifdef BACKGROUND_SWEEP
+          /* The block may have been dropped from a reclaim list before */
+          /* it was taken from the sweeper.                             */
+          hhdr -> hb_sweep_state = SWEEP_NONE;
+#       endif
 #       ifdef PARALLEL_MARK
           /* Count can be low or one too high because we sometimes      */
           /* have to ignore decrements.  Objects can also potentially   */
@@ -497,6 +750,14 @@ STATIC void GC_reclaim_block(struct hblk *hbp, word report_if_found)
         } else {
           GC_composite_in_use += sz * hhdr -> hb_n_marks;
         }
+#       ifdef ESCARGOT
+          /* Empty blocks have been freed above.        */
+          if (hhdr -> hb_n_marks != 0) {
+            GC_marked_objs += hhdr -> hb_n_marks;
+            GC_blocks_in_use++;
+            GC_block_bytes_in_use += HBLKSIZE;
+          }
+#       endif
     }
 }
 
@@ -535,14 +796,18 @@ unsigned GC_n_set_marks(hdr *hhdr)
 /* Number of set bits in a word.  Not performance critical.     */
 static unsigned set_bits(word n)
 {
-    word m = n;
-    unsigned result = 0;
+#   if GC_GNUC_PREREQ(3, 4)
+      return (unsigned)__builtin_popcountll((unsigned long long)n);
+#   else
+      word m = n;
+      unsigned result = 0;
 
-    while (m > 0) {
+      while (m > 0) {
         if (m & 1) result++;
         m >>= 1;
-    }
-    return(result);
+      }
+      return(result);
+#   endif
 }
 
 unsigned GC_n_set_marks(hdr *hhdr)
@@ -641,130 +906,74 @@ GC_API void GC_CALL GC_print_free_list(int kind, size_t sz_in_granules)
 #include <sys/resource.h>
 #endif
 
-#if defined(NO_DEBUGGING)
-
-#ifdef USE_MARK_BYTES
+STATIC MAY_THREAD_LOCAL FILE *GC_graph_log_file = NULL;
+STATIC MAY_THREAD_LOCAL char *GC_graph_log_file_name = NULL;
 
-int GC_n_set_marks(hdr *hhdr)
+GC_API void GC_CALL GC_get_heap_occupancy(struct GC_heap_occupancy *occupancy)
 {
-    int result = 0;
-    int i;
-    size_t sz = hhdr -> hb_sz;
-    int offset = (int)MARK_BIT_OFFSET(sz);
-    int limit = (int)FINAL_MARK_BIT(sz);
+    DCL_LOCK_STATE;
 
-    for (i = 0; i < limit; i += offset) {
-        result += hhdr -> hb_marks[i];
-    }
-    GC_ASSERT(hhdr -> hb_marks[limit]);
-    return(result);
+    LOCK();
+    occupancy -> gc_no = GC_gc_no;
+    occupancy -> heap_size = GC_heapsize;
+    occupancy -> blocks_in_use = GC_blocks_in_use;
+    occupancy -> block_bytes_in_use = GC_block_bytes_in_use;
+    occupancy -> marked_objs = GC_marked_objs;
+    occupancy -> marked_bytes = GC_composite_in_use + GC_atomic_in_use;
+    UNLOCK();
 }
 
-#else // USE_MARK_BYTES
-
-static int set_bits(word n)
+/* The log file is kept open, so only the first dump to a file opens it. */
+STATIC FILE *GC_get_graph_log_file(const char *log_file_name)
 {
-    word m = n;
-    int result = 0;
-
-    while (m > 0) {
-        if (m & 1) result++;
-        m >>= 1;
+    if (GC_graph_log_file != NULL
+        && strcmp(GC_graph_log_file_name, log_file_name) != 0) {
+        fclose(GC_graph_log_file);
+        free(GC_graph_log_file_name);
+        GC_graph_log_file = NULL;
     }
-    return(result);
-}
-
-int GC_n_set_marks(hdr *hhdr)
-{
-    int result = 0;
-    int i;
-    int n_mark_words;
-#   ifdef MARK_BIT_PER_OBJ
-      int n_objs = (int)HBLK_OBJS(hhdr -> hb_sz);
-
-      if (0 == n_objs) n_objs = 1;
-      n_mark_words = divWORDSZ(n_objs + WORDSZ - 1);
-#   else /* MARK_BIT_PER_GRANULE */
-      n_mark_words = MARK_BITS_SZ;
-#   endif
-    for (i = 0; i < n_mark_words - 1; i++) {
-        result += set_bits(hhdr -> hb_marks[i]);
+    if (GC_graph_log_file == NULL) {
+        GC_graph_log_file_name = strdup(log_file_name);
+        if (GC_graph_log_file_name == NULL)
+            return NULL;
+        GC_graph_log_file = fopen(log_file_name, "a");
+        if (GC_graph_log_file == NULL) {
+            free(GC_graph_log_file_name);
+            GC_graph_log_file_name = NULL;
+        }
     }
-#   ifdef MARK_BIT_PER_OBJ
-      result += set_bits((hhdr -> hb_marks[n_mark_words - 1])
-                         << (n_mark_words * WORDSZ - n_objs));
-#   else
-      result += set_bits(hhdr -> hb_marks[n_mark_words - 1]);
-#   endif
-    return(result - 1);
-}
-
-#endif // USE_MARK_BYTES
-
-#endif // defined(NO_DEBUGGING)
-
-struct Print_stats_escargot
-{
-        size_t number_of_blocks;
-        size_t total_bytes;
-        size_t marked_num;
-        size_t marked_bytes;
-};
-
-STATIC void GC_gather_information_for_escargot(struct hblk *h,
-                                               word raw_pse)
-{
-    hdr * hhdr = HDR(h);
-    size_t bytes = hhdr -> hb_sz;
-    struct Print_stats_escargot *pse;
-    unsigned n_marks = GC_n_set_marks(hhdr);
-
-    GC_ASSERT(hhdr -> hb_n_marks == n_marks);
-
-    bytes += HBLKSIZE-1;
-    bytes &= ~(HBLKSIZE-1);
-
-    pse = (struct Print_stats_escargot *)raw_pse;
-    pse->number_of_blocks++;
-    pse->total_bytes += bytes;
-    pse->marked_num += n_marks;
-    pse->marked_bytes += (hhdr->hb_sz) * n_marks;
+    return GC_graph_log_file;
 }
 
 GC_API void GC_CALL GC_dump_for_graph(const char* log_file_name,
                                       const char* phase_name)
 {
-    struct Print_stats_escargot pstats;
+    struct GC_heap_occupancy occupancy;
     size_t peak_rss;
 #if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
     struct rusage ru;
 #endif
 
-    pstats.number_of_blocks = 0;
-    pstats.total_bytes = 0;
-    pstats.marked_num = 0;
-    pstats.marked_bytes = 0;
-
-    GC_apply_to_all_blocks(GC_gather_information_for_escargot, (word)&pstats);
+    GC_get_heap_occupancy(&occupancy);
 
 #if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
     getrusage(RUSAGE_SELF, &ru);
     peak_rss = ru.ru_maxrss;
 
     GC_printf("[%lu] %s : PeakRSS %zu KB, TotalHeap %lu KB, MarkedHeap %lu KB\n",
-              (unsigned long) GC_get_gc_no(), phase_name, peak_rss,
-              (unsigned long) pstats.total_bytes / 1024,
-              (unsigned long) pstats.marked_bytes / 1024);
+              (unsigned long) occupancy.gc_no, phase_name, peak_rss,
+              (unsigned long) occupancy.block_bytes_in_use / 1024,
+              (unsigned long) occupancy.marked_bytes / 1024);
 
-    FILE* fp = fopen(log_file_name, "a");
+    FILE* fp = GC_get_graph_log_file(log_file_name);
     if (fp) {
         fprintf(fp, "%5lu %9zu %9lu %9lu     # %s\n",
-                (unsigned long) GC_get_gc_no(),
+                (unsigned long) occupancy.gc_no,
                 peak_rss,
-                (unsigned long) pstats.total_bytes / 1024,
-                (unsigned long) pstats.marked_bytes / 1024,
+                (unsigned long) occupancy.block_bytes_in_use / 1024,
+                (unsigned long) occupancy.marked_bytes / 1024,
                 phase_name);
-        fclose(fp);
+        fflush(fp);
     }
 #endif
 }
@@ -789,6 +998,168 @@ STATIC void GC_clear_fl_links(void **flp)
     }
 }
 
+#ifdef BACKGROUND_SWEEP
+GC_INLINE GC_bool GC_can_sweep_in_background(hdr *hhdr)
+{
+  /* Reclaim notifiers are client code which runs with the lock held.   */
+# ifdef ENABLE_DISCLAIM
+    if ((hhdr -> hb_flags & HAS_DISCLAIM) != 0) return FALSE;
+# endif
+  return !IS_UNCOLLECTABLE(hhdr -> hb_obj_kind);
+}
+
+/* Queue the blocks of the reclaim lists for the background sweeper,    */
+/* and sweep the others.  Returns FALSE, leaving the lists untouched,   */
+/* if there are too few blocks to queue.                                */
+STATIC GC_bool GC_start_background_sweep(void)
+{
+  GC_sweep_job *job;
+  GC_sweep_job **link;
+  struct GC_sweep_item *item;
+  size_t n_blocks = 0;
+  unsigned kind;
+  word sz;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(NULL == GC_sweep_job_posted);
+  for (kind = 0; kind < GC_n_kinds; kind++) {
+    struct hblk **rlp = GC_obj_kinds[kind].ok_reclaim_list;
+
+    if (NULL == rlp) continue;
+    for (sz = 1; sz <= MAXOBJGRANULES; sz++) {
+      struct hblk *hbp;
+
+      for (hbp = rlp[sz]; hbp != NULL; hbp = HDR(hbp) -> hb_next) {
+        if (GC_can_sweep_in_background(HDR(hbp)))
+          n_blocks++;
+      }
+    }
+  }
+  if (n_blocks < BACKGROUND_SWEEP_MIN_BLOCKS)
+    return FALSE;
+
+  pthread_mutex_lock(&GC_sweeper_lock);
+  if (!GC_sweeper_started) {
+    pthread_attr_t attr;
+    pthread_t thread;
+    int err = -1;
+
+    if (pthread_attr_init(&attr) == 0) {
+      (void)pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+      err = pthread_create(&thread, &attr, GC_sweeper_thread, NULL);
+      (void)pthread_attr_destroy(&attr);
+    }
+    if (err != 0) {
+      pthread_mutex_unlock(&GC_sweeper_lock);
+      WARN("Creating background sweeper thread failed\n", 0);
+      return FALSE;
+    }
+    GC_sweeper_started = TRUE;
+  }
+  pthread_mutex_unlock(&GC_sweeper_lock);
+
+  job = (GC_sweep_job *)malloc(sizeof(GC_sweep_job)
+                               + (n_blocks - 1)
+                                 * sizeof(struct GC_sweep_item));
+  if (NULL == job)
+    return FALSE;
+  BZERO(job, sizeof(GC_sweep_job));
+  item = job -> sj_items;
+  for (kind = 0; kind < GC_n_kinds; kind++) {
+    struct obj_kind *ok = &GC_obj_kinds[kind];
+
+    if (NULL == ok -> ok_reclaim_list) continue;
+    for (sz = 1; sz <= MAXOBJGRANULES; sz++) {
+      struct hblk **rlh = ok -> ok_reclaim_list + sz;
+      struct hblk *hbp;
+
+      while ((hbp = *rlh) != NULL) {
+        hdr *hhdr = HDR(hbp);
+
+        if (GC_can_sweep_in_background(hhdr)) {
+          hhdr -> hb_sweep_state = SWEEP_QUEUED;
+          item -> si_hbp = hbp;
+          item -> si_hhdr = hhdr;
+          item -> si_sz = hhdr -> hb_sz;
+          item -> si_init = ok -> ok_init || GC_debugging_started;
+          item++;
+          rlh = &(hhdr -> hb_next);
+        } else {
+          *rlh = hhdr -> hb_next;
+          GC_reclaim_small_nonempty_block(hbp, hhdr -> hb_sz, FALSE);
+        }
+      }
+    }
+  }
+  job -> sj_n_items = (size_t)(item - job -> sj_items);
+  GC_ASSERT(job -> sj_n_items == n_blocks);
+
+  pthread_mutex_lock(&GC_sweeper_lock);
+  for (link = &GC_sweep_jobs; *link != NULL; link = &(*link) -> sj_next) {
+    /* empty */
+  }
+  *link = job;
+  pthread_cond_signal(&GC_sweeper_cond);
+  pthread_mutex_unlock(&GC_sweeper_lock);
+  GC_sweep_job_posted = job;
+  return TRUE;
+}
+
+GC_INNER void GC_finish_background_sweep(void)
+{
+  GC_sweep_job *job = GC_sweep_job_posted;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  if (NULL == job) return;
+  GC_sweep_job_posted = NULL;
+  __atomic_store_n(&job -> sj_cancelled, 1, __ATOMIC_RELAXED);
+  pthread_mutex_lock(&GC_sweeper_lock);
+  if (!job -> sj_running) {
+    GC_sweep_job **link;
+
+    for (link = &GC_sweep_jobs; *link != job; link = &(*link) -> sj_next) {
+      /* empty */
+    }
+    *link = job -> sj_next;
+  } else {
+    while (!job -> sj_finished)
+      pthread_cond_wait(&GC_sweeper_done_cond, &GC_sweeper_lock);
+  }
+  pthread_mutex_unlock(&GC_sweeper_lock);
+  free(job);
+
+  /* The blocks left queued are swept (or taken, if the sweeper has     */
+  /* done them) by the allocator.  Those of the kinds which must be     */
+  /* swept before marking are finished here; the other ones are         */
+  /* dropped by GC_start_reclaim, as with lazy sweeping.                */
+  GC_reclaim_unconditionally_marked();
+}
+#endif /* BACKGROUND_SWEEP */
+
+#ifdef ESCARGOT
+  GC_API void GC_CALL GC_set_background_sweep(int value)
+  {
+#   ifdef BACKGROUND_SWEEP
+      DCL_LOCK_STATE;
+
+      LOCK();
+      GC_background_sweep = value;
+      UNLOCK();
+#   else
+      (void)value;
+#   endif
+  }
+
+  GC_API int GC_CALL GC_get_background_sweep(void)
+  {
+#   ifdef BACKGROUND_SWEEP
+      return GC_background_sweep;
+#   else
+      return 0;
+#   endif
+  }
+#endif /* ESCARGOT */
+
 /*
  * Perform GC_reclaim_block on the entire heap, after first clearing
  * small object free lists (if we are not just looking for leaks).
@@ -799,10 +1170,19 @@ GC_INNER void GC_start_reclaim(GC_bool report_if_found)
 
 #   if defined(PARALLEL_MARK)
       GC_ASSERT(0 == GC_fl_builder_count);
+#   endif
+#   ifdef BACKGROUND_SWEEP
+      /* Finished before marking.       */
+      GC_ASSERT(NULL == GC_sweep_job_posted);
 #   endif
     /* Reset in use counters.  GC_reclaim_block recomputes them. */
       GC_composite_in_use = 0;
       GC_atomic_in_use = 0;
+#     ifdef ESCARGOT
+        GC_marked_objs = 0;
+        GC_blocks_in_use = 0;
+        GC_block_bytes_in_use = 0;
+#     endif
     /* Clear reclaim- and free-lists */
       for (kind = 0; kind < GC_n_kinds; kind++) {
         struct hblk ** rlist = GC_obj_kinds[kind].ok_reclaim_list;
@@ -833,7 +1213,20 @@ GC_INNER void GC_start_reclaim(GC_bool report_if_found)
   /* or enqueue the block for later processing.                            */
     GC_apply_to_all_blocks(GC_reclaim_block, (word)report_if_found);
 
+# ifdef BACKGROUND_SWEEP
+    if (GC_background_sweep && !report_if_found && !GC_incremental
+        && GC_start_background_sweep())
+      return;
+# endif
 # ifdef EAGER_SWEEP
+#   if defined(GC_PACER) && (defined(ENABLE_DISCLAIM) || defined(ESCARGOT))
+      /* The pacer sweeps the other kinds in its own slices.            */
+      if (GC_incremental && GC_pause_target_us != 0 && !report_if_found) {
+        GC_reclaim_unconditionally_marked();
+        GC_pacer_sweep_pending = TRUE;
+        return;
+      }
+#   endif
     /* This is a very stupid thing to do.  We make it possible anyway,  */
     /* so that you can convince yourself that it really is very stupid. */
     GC_reclaim_all((GC_stop_func)0, FALSE);
@@ -932,7 +1325,9 @@ GC_INNER GC_bool GC_reclaim_all(GC_stop_func stop_func, GC_bool ignore_old)
     return(TRUE);
 }
 
-#if !defined(EAGER_SWEEP) && (defined(ENABLE_DISCLAIM) || defined(ESCARGOT))
+#if (!defined(EAGER_SWEEP) || defined(BACKGROUND_SWEEP) \
+     || defined(GC_PACER)) \
+    && (defined(ENABLE_DISCLAIM) || defined(ESCARGOT))
 /* We do an eager sweep on heap blocks where unconditional marking has  */
 /* been enabled, so that any reclaimable objects have been reclaimed    */
 /* before we start marking.  This is a simplified GC_reclaim_all        */
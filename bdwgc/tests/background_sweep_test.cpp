@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check that with GC_set_background_sweep, the client may allocate     */
+/* right after each collection, while the helper thread sweeps: the     */
+/* objects handed out are cleared (unless pointer-free) and do not      */
+/* overlap the live ones, and the space of the garbage is reused, so    */
+/* that the heap stops growing.                                         */
+
+#include "gc.h"
+#include "gc_mark.h"
+
+#include <cstdio>
+#include <cstring>
+
+#define ROUNDS 20
+#define LIVE 2000
+#define GARBAGE_PER_LIVE 8
+#define LIVE_BYTE 0xa5
+#define NEW_BYTE 0x3c
+
+static const size_t s_sizes[] = { 16, 48, 96, 256, 1024 };
+#define N_SIZES (sizeof(s_sizes) / sizeof(s_sizes[0]))
+
+static int s_failures = 0;
+
+static bool isFilled(const unsigned char* p, size_t size, unsigned char value)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (p[i] != value)
+            return false;
+    }
+    return true;
+}
+
+static void* allocate(size_t size, bool atomic)
+{
+    return atomic ? GC_MALLOC_ATOMIC(size) : GC_MALLOC(size);
+}
+
+// Replace the live objects of the given size, leaving behind the old
+// ones and more garbage, so that the blocks of the size are mostly
+// free after the next collection.
+static void __attribute__((noinline)) churn(void** live, size_t size, bool atomic)
+{
+    for (size_t i = 0; i < LIVE; i++) {
+        for (size_t j = 0; j < GARBAGE_PER_LIVE; j++)
+            memset(allocate(size, atomic), NEW_BYTE, size);
+        live[i] = allocate(size, atomic);
+        memset(live[i], LIVE_BYTE, size);
+    }
+}
+
+// Allocate while the helper may still be sweeping the same blocks.
+static void __attribute__((noinline)) allocateAfterCollection(size_t size, bool atomic)
+{
+    for (size_t i = 0; i < LIVE * GARBAGE_PER_LIVE; i++) {
+        unsigned char* p = (unsigned char*)allocate(size, atomic);
+        if (!atomic && !isFilled(p, size, 0)) {
+            fprintf(stderr, "background_sweep_test: object of %zu bytes is not cleared\n", size);
+            s_failures++;
+            return;
+        }
+        memset(p, NEW_BYTE, size);
+    }
+}
+
+static void checkLive(void*** live)
+{
+    for (size_t k = 0; k < 2 * N_SIZES; k++) {
+        for (size_t i = 0; i < LIVE; i++) {
+            if (!isFilled((unsigned char*)live[k][i], s_sizes[k / 2], LIVE_BYTE)) {
+                fprintf(stderr, "background_sweep_test: live object of %zu bytes%s was reclaimed\n",
+                        s_sizes[k / 2], k % 2 ? " (atomic)" : "");
+                s_failures++;
+                return;
+            }
+        }
+    }
+}
+
+int main()
+{
+    GC_set_background_sweep(1);
+    GC_INIT();
+
+    // For each size, the normal objects, then the pointer-free ones.
+    void*** live = (void***)GC_MALLOC_UNCOLLECTABLE(2 * N_SIZES * sizeof(void**));
+    for (size_t k = 0; k < 2 * N_SIZES; k++)
+        live[k] = (void**)GC_MALLOC_UNCOLLECTABLE(LIVE * sizeof(void*));
+
+    size_t heapSize = 0;
+    for (int round = 0; round < ROUNDS && !s_failures; round++) {
+        for (size_t k = 0; k < 2 * N_SIZES; k++)
+            churn(live[k], s_sizes[k / 2], k % 2);
+        GC_gcollect();
+        for (size_t k = 0; k < 2 * N_SIZES; k++)
+            allocateAfterCollection(s_sizes[k / 2], k % 2);
+        checkLive(live);
+        if (round == ROUNDS / 2)
+            heapSize = GC_get_heap_size();
+    }
+    if (!s_failures && GC_get_heap_size() > 2 * heapSize) {
+        fprintf(stderr, "background_sweep_test: the heap grew from %zu to %zu bytes\n",
+                heapSize, GC_get_heap_size());
+        s_failures++;
+    }
+
+    if (s_failures)
+        return 1;
+    printf("background_sweep_test: passed (%zu KiB heap)\n", GC_get_heap_size() >> 10);
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check that the card-marking write barrier (WriteBarrier.h) keeps     */
+/* alive an object which, during an incremental collection in the       */
+/* manual VDB mode, is moved into a holder which was already scanned    */
+/* out of a carrier which was not scanned yet: only the card of the     */
+/* holder tells the collector to scan it again.                         */
+
+#include "WriteBarrier.h"
+
+#include <cstdio>
+
+#define PAIRS 50000
+#define WARMUP_COLLECTIONS 5
+
+// Of another size than a carrier, so that they are not in the same
+// blocks (and cards).
+struct Holder {
+    void* young;
+    void* unused[3];
+};
+
+struct Carrier {
+    void* target;
+};
+
+// The roots hold the holders first, then the carriers, so that the
+// holders are scanned before the carriers. The targets are only
+// referenced from the carriers.
+static void __attribute__((noinline)) build(void** roots)
+{
+    for (size_t i = 0; i < PAIRS; i++) {
+        GCUtil::storePointer(roots[i], GC_MALLOC(sizeof(Holder)));
+        Carrier* carrier = (Carrier*)GC_MALLOC(sizeof(Carrier));
+        GCUtil::storePointer(carrier->target, GC_MALLOC_ATOMIC(sizeof(GC_word)));
+        GCUtil::storePointer(roots[PAIRS + i], carrier);
+    }
+}
+
+// Move the targets from the carriers into the holders, and return how
+// many of them were only referenced from a carrier not scanned yet by a
+// holder already scanned.
+static size_t __attribute__((noinline)) moveTargets(void** roots)
+{
+    size_t unprotected = 0;
+    for (size_t i = 0; i < PAIRS; i++) {
+        Holder* holder = (Holder*)roots[i];
+        Carrier* carrier = (Carrier*)roots[PAIRS + i];
+        if (GC_is_marked(holder) && !GC_is_marked(carrier->target))
+            unprotected++;
+        GCUtil::storePointer(holder->young, carrier->target);
+        GCUtil::storePointer(carrier->target, (void*)NULL);
+    }
+    return unprotected;
+}
+
+int main()
+{
+    GC_set_manual_vdb_allowed(1);
+    GC_INIT();
+    GC_enable_incremental();
+    // Abandon the world-stop marking at once, so the marking is done in
+    // steps, and clear the marks for each collection.
+    GC_set_time_limit(0);
+    GC_set_full_freq(0);
+    if (!GC_is_incremental_mode()) {
+        printf("card_table_test: skipped (no incremental mode)\n");
+        return 0;
+    }
+
+    void** roots = (void**)GC_MALLOC_UNCOLLECTABLE(2 * PAIRS * sizeof(void*));
+    build(roots);
+    // Finish any collection started by the allocations (whose cards then
+    // mark every holder), and grow the mark stack until it does not
+    // overflow, which would make the collector rescan every object.
+    for (int i = 0; i < WARMUP_COLLECTIONS; i++)
+        GC_gcollect();
+
+    // Start a collection (allocating until one is due), and mark until
+    // the last holder is reached.
+    while (!GC_collect_a_little())
+        GC_MALLOC(64);
+    GC_word gcNo = GC_get_gc_no();
+    while (!GC_is_marked(roots[PAIRS - 1])) {
+        GC_collect_a_little();
+        if (GC_get_gc_no() != gcNo) {
+            fprintf(stderr, "card_table_test: the collection ended before the holders were marked\n");
+            return 1;
+        }
+    }
+
+    size_t unprotected = moveTargets(roots);
+    // Finish the collection (but do not start the next one).
+    while (GC_get_gc_no() == gcNo)
+        GC_collect_a_little();
+
+    size_t lost = 0;
+    for (size_t i = 0; i < PAIRS; i++) {
+        Holder* holder = (Holder*)roots[i];
+        if (!holder->young || !GC_is_marked(holder->young))
+            lost++;
+    }
+    printf("card_table_test: %zu of %zu targets only kept by the barrier\n", unprotected, (size_t)PAIRS);
+    if (lost) {
+        fprintf(stderr, "card_table_test: %zu targets were not marked\n", lost);
+        return 1;
+    }
+    if (!unprotected) {
+        fprintf(stderr, "card_table_test: no holder was scanned before its carrier\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check that the objects reachable only through compressed pointers    */
+/* survive collections, both through small (inline) descriptors and    */
+/* through extended descriptors which need a continuation, and that    */
+/* small integers in the stack, which are checked as compressed         */
+/* pointers too, do not keep objects alive. It is also built with       */
+/* GC_DEBUG, in which the typed allocation macros drop the descriptor.  */
+
+#include "Compressed.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace GCUtil;
+
+struct Node {
+    uint32_t id;
+    Compressed<Node> left;
+    Compressed<Node> right;
+    uint32_t check;
+};
+
+typedef CompressedTypedAllocation<Node, offsetof(Node, left), offsetof(Node, right)> NodeAllocation;
+
+// The pointer slots are beyond the inline bitmap, and b is beyond the
+// first word of the extended bitmap.
+struct Big {
+    uint32_t fill[100];
+    Compressed<Node> a;
+    uint32_t fill2[150];
+    Compressed<Node> b;
+    uint32_t tail;
+};
+
+typedef CompressedTypedAllocation<Big, offsetof(Big, a), offsetof(Big, b)> BigAllocation;
+
+#define DEPTH 10
+#define TREE_SIZE ((1L << (DEPTH + 1)) - 1)
+
+static uint32_t s_nextId = 1;
+
+static Node* build(int depth)
+{
+    Node* node = NodeAllocation::create();
+    node->id = s_nextId++;
+    node->check = ~node->id;
+    if (depth > 0) {
+        node->left = build(depth - 1);
+        node->right = build(depth - 1);
+    }
+    return node;
+}
+
+#define VICTIMS 256
+#define SMALL_INTS 65536 /* Multiples of 16 up to 1 MiB. */
+
+// The victims are only reachable through the disappearing links.
+static void __attribute__((noinline)) allocateVictims(void** links)
+{
+    for (int i = 0; i < VICTIMS; i++) {
+        links[i] = NodeAllocation::create();
+        GC_GENERAL_REGISTER_DISAPPEARING_LINK(&links[i], links[i]);
+    }
+}
+
+static void __attribute__((noinline)) collectWithSmallInts()
+{
+    volatile uint32_t ints[SMALL_INTS];
+    for (uint32_t i = 0; i < SMALL_INTS; i++)
+        ints[i] = i * 16;
+    GC_gcollect();
+    (void)ints[0];
+}
+
+static bool smallIntsAreNotRoots()
+{
+    void** links = (void**)malloc(VICTIMS * sizeof(void*));
+    // No collection before the integers are in the stack.
+    GC_disable();
+    allocateVictims(links);
+    GC_enable();
+    collectWithSmallInts();
+
+    int retained = 0;
+    for (int i = 0; i < VICTIMS; i++) {
+        if (links[i])
+            retained++;
+    }
+    free(links);
+    // A few may still be referenced from what is left of the frames.
+    if (retained * 2 > VICTIMS) {
+        fprintf(stderr, "compressed_test: small integers retained %d of %d objects\n", retained, VICTIMS);
+        return false;
+    }
+    return true;
+}
+
+static long count(Node* node)
+{
+    if (!node)
+        return 0;
+    if (node->check != ~node->id) {
+        fprintf(stderr, "compressed_test: node %u was collected\n", node->id);
+        exit(1);
+    }
+    return 1 + count(node->left) + count(node->right);
+}
+
+int main(void)
+{
+    GC_INIT();
+
+    // First, while the heap is small.
+    if (!smallIntsAreNotRoots())
+        return 1;
+
+    // The trees are reachable only through compressed slots.
+    Big** holder = (Big**)GC_MALLOC_UNCOLLECTABLE(sizeof(Big*));
+    Big* big = BigAllocation::create();
+    memset(big->fill, 0xff, sizeof(big->fill));
+    big->a = build(DEPTH);
+    big->b = build(DEPTH);
+    *holder = big;
+    big = nullptr;
+
+    for (int i = 0; i < 10; i++) {
+        build(DEPTH); // garbage which reuses the freed nodes
+        GC_gcollect();
+    }
+
+    long nodes = count((*holder)->a) + count((*holder)->b);
+    if (nodes != 2 * TREE_SIZE) {
+        fprintf(stderr, "compressed_test: %ld nodes, expected %ld\n", nodes, 2 * TREE_SIZE);
+        return 1;
+    }
+    printf("compressed_test: %ld nodes survived %lu collections\n", nodes, (unsigned long)GC_get_gc_no());
+    return 0;
+}
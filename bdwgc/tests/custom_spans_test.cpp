@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check that GC_mark_and_push_custom_spans keeps alive what the spans  */
+/* of an object point to, both the single fields which are scanned in   */
+/* place and the long runs which are pushed as ranges, across several   */
+/* calls of the span procedure, and that the fields outside the spans   */
+/* are not scanned.                                                     */
+
+#include "gc.h"
+#include "gc_mark.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#define CONTAINERS 32
+#define WORDS 100
+#define SINGLES_END 41 /* Odd fields below are single spans. */
+#define SPANS_PER_CALL 4
+#define TARGET_WORDS 2
+
+static int s_failures = 0;
+
+static void fail(const char* message, size_t container, size_t field)
+{
+    fprintf(stderr, "custom_spans_test: %s (object %zu, field %zu)\n", message, container, field);
+    s_failures++;
+}
+
+static bool isScanned(size_t field)
+{
+    return field >= SINGLES_END || field % 2 == 1;
+}
+
+// Field 0 is a tag, then the odd fields up to SINGLES_END are spans of
+// one word, and the rest of the object is a single long span.
+static size_t spansOf(GC_word* ptr, GC_word* end, GC_word** nextPtr,
+                      struct GC_mark_span* spans, size_t maxSpans)
+{
+    GC_word* base = (GC_word*)GC_base(ptr);
+    size_t field = ptr - base;
+    size_t n = 0;
+
+    if (field == 0)
+        field = 1;
+    while (n < maxSpans && n < SPANS_PER_CALL && field < WORDS) {
+        if (field < SINGLES_END) {
+            spans[n].from = base + field;
+            spans[n].to = base + field + 1;
+            field += 2;
+        } else {
+            spans[n].from = base + field;
+            spans[n].to = base + WORDS;
+            field = WORDS;
+        }
+        n++;
+    }
+    *nextPtr = field < WORDS ? base + field : end;
+    return n;
+}
+
+static struct GC_ms_entry* markContainer(GC_word* addr, struct GC_ms_entry* markStackPtr,
+                                         struct GC_ms_entry* markStackLimit, GC_word)
+{
+    return GC_mark_and_push_custom_spans(addr, markStackPtr, markStackLimit, spansOf);
+}
+
+static GC_word* s_links[CONTAINERS][WORDS];
+
+// The targets are only referenced from the containers once this returns.
+static void __attribute__((noinline)) fill(GC_word** containers, int kind)
+{
+    for (size_t i = 0; i < CONTAINERS; i++) {
+        GC_word* container = (GC_word*)GC_generic_malloc(WORDS * sizeof(GC_word), kind);
+        container[0] = i;
+        for (size_t field = 1; field < WORDS; field++) {
+            GC_word* target = (GC_word*)GC_MALLOC_ATOMIC(TARGET_WORDS * sizeof(GC_word));
+            target[0] = i;
+            target[1] = field;
+            container[field] = (GC_word)target;
+            s_links[i][field] = target;
+            GC_GENERAL_REGISTER_DISAPPEARING_LINK((void**)&s_links[i][field], target);
+        }
+        containers[i] = container;
+    }
+}
+
+int main()
+{
+    GC_INIT();
+
+    int kind = (int)GC_new_kind(GC_new_free_list(), GC_MAKE_PROC(GC_new_proc(markContainer), 0), 0, 1);
+    GC_word** containers = (GC_word**)GC_MALLOC(CONTAINERS * sizeof(GC_word*));
+    fill(containers, kind);
+
+    for (int round = 0; round < 3; round++)
+        GC_gcollect();
+
+    size_t unscanned = 0, collected = 0;
+    for (size_t i = 0; i < CONTAINERS; i++) {
+        GC_word* container = containers[i];
+        if (container[0] != i)
+            fail("tag changed", i, 0);
+        for (size_t field = 1; field < WORDS; field++) {
+            GC_word* target = (GC_word*)container[field];
+            if (!isScanned(field)) {
+                unscanned++;
+                if (!s_links[i][field])
+                    collected++;
+                continue;
+            }
+            if (!s_links[i][field])
+                fail("target was collected", i, field);
+            else if (target[0] != i || target[1] != field)
+                fail("target was overwritten", i, field);
+        }
+    }
+    // Fields outside the spans are not scanned; a few of their targets
+    // may still be found by the conservative scan of the stack.
+    if (collected * 2 < unscanned) {
+        fprintf(stderr, "custom_spans_test: only %zu of %zu unscanned targets were collected\n",
+                collected, unscanned);
+        s_failures++;
+    }
+
+    if (s_failures)
+        return 1;
+    printf("custom_spans_test: passed\n");
+    return 0;
+}
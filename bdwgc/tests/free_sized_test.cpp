@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check that GC_free_sized puts an object back to the free list of its */
+/* own size class, whatever size the caller passes, and that the count  */
+/* returned by allocate_at_least fits into the object.  It is run with  */
+/* all interior pointers, so the objects have an extra byte at the end. */
+
+#include "Allocator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace GCUtil;
+
+#define OBJECTS 64
+#define PATTERN 0x5a
+
+static int s_failures = 0;
+
+static void fail(const char* message)
+{
+    fprintf(stderr, "free_sized_test: %s\n", message);
+    s_failures++;
+}
+
+static bool intact(unsigned char* p, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; i++) {
+        if (p[i] != PATTERN)
+            return false;
+    }
+    return true;
+}
+
+// Frees every other object with the given size and checks that the
+// neighbours are not overwritten by the objects allocated next.
+static void checkFreeSized(size_t lb, size_t freedSize(void*))
+{
+    unsigned char** objects = (unsigned char**)GC_MALLOC_UNCOLLECTABLE(sizeof(void*) * OBJECTS);
+    for (int i = 0; i < OBJECTS; i++) {
+        objects[i] = (unsigned char*)GC_MALLOC(lb);
+        memset(objects[i], PATTERN, lb);
+    }
+    for (int i = 0; i < OBJECTS; i += 2) {
+        GC_free_sized(objects[i], freedSize(objects[i]), GC_I_NORMAL);
+    }
+    for (int i = 0; i < OBJECTS; i++) {
+        // One granule more than fits into an object of the freed class.
+        unsigned char* p = (unsigned char*)GC_MALLOC(GC_size(objects[1]) + 8);
+        memset(p, 0xff, GC_size(p) - 1);
+        p = (unsigned char*)GC_MALLOC(lb);
+        memset(p, 0xff, lb);
+    }
+    for (int i = 1; i < OBJECTS; i += 2) {
+        if (!intact(objects[i], lb)) {
+            fail("a neighbour of a freed object was overwritten");
+            break;
+        }
+    }
+    GC_FREE(objects);
+}
+
+static size_t wholeSize(void* p) { return GC_size(p); }
+static size_t oneWord(void*) { return sizeof(void*); }
+
+int main(void)
+{
+    GC_set_all_interior_pointers(1);
+    GC_INIT();
+
+    checkFreeSized(40, wholeSize);
+    checkFreeSized(40, oneWord);
+    checkFreeSized(100, wholeSize);
+
+    gc_malloc_allocator<char> allocator;
+    for (size_t n = 1; n < 300; n++) {
+        gc_allocation_result<char> result = allocator.allocate_at_least(n);
+        if (result.count < n || result.count >= GC_size(result.ptr)) {
+            fail("allocate_at_least reported the extra byte as usable");
+            break;
+        }
+        memset(result.ptr, 0xff, result.count);
+        allocator.deallocate(result.ptr, result.count);
+    }
+
+    if (!s_failures)
+        printf("free_sized_test: passed\n");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check the precise stack roots of HandleScope: the objects kept in    */
+/* handles (more than a chunk of them, and through copied handles)      */
+/* survive collections while the ones only referenced from the native   */
+/* stack are collected, and, in the hybrid mode, the stack below a      */
+/* ConservativeStackScope is still scanned conservatively.              */
+
+#include "HandleScope.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace GCUtil;
+
+struct Node {
+    size_t id;
+    size_t check;
+};
+
+#define HANDLES (3 * HandleScope::ChunkSlots + 7)
+#define VICTIMS 64
+
+static int s_failures = 0;
+
+static void fail(const char* message)
+{
+    fprintf(stderr, "handle_scope_test: %s\n", message);
+    s_failures++;
+}
+
+static Node* newNode(size_t id)
+{
+    Node* node = (Node*)GC_MALLOC_ATOMIC(sizeof(Node));
+    node->id = id;
+    node->check = ~id;
+    return node;
+}
+
+static bool isIntact(Node* node, size_t id)
+{
+    return node && node->id == id && node->check == ~id;
+}
+
+// The links are in malloc memory, which is not scanned.
+static void** newLinks(Node** nodes, size_t count)
+{
+    void** links = (void**)malloc(count * sizeof(void*));
+    for (size_t i = 0; i < count; i++) {
+        links[i] = nodes[i];
+        GC_GENERAL_REGISTER_DISAPPEARING_LINK(links + i, nodes[i]);
+    }
+    return links;
+}
+
+static size_t countCleared(void** links, size_t count)
+{
+    size_t cleared = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!links[i])
+            cleared++;
+        else
+            GC_unregister_disappearing_link(links + i);
+    }
+    free(links);
+    return cleared;
+}
+
+static void __attribute__((noinline)) checkCopiedHandle()
+{
+    HandleScope scope;
+    Handle<Node> original(newNode(1));
+    Handle<Node> copy(original);
+    size_t count = HandleScope::handleCount();
+
+    original = newNode(2);
+    if (!isIntact(copy, 1))
+        fail("assigning to a handle changed its copy");
+    copy = newNode(3);
+    if (!isIntact(original, 2))
+        fail("assigning to a copy changed the original handle");
+
+    // The copy is the only root of its object.
+    copy = original;
+    original = newNode(4);
+    GC_gcollect();
+    if (!isIntact(copy, 2) || !isIntact(original, 4))
+        fail("an object only kept by a copied handle was collected");
+
+    {
+        HandleScope inner;
+        Handle<Node> innerCopy(copy);
+        if (HandleScope::handleCount() != count + 1)
+            fail("a copied handle did not take a slot of the innermost scope");
+    }
+    if (HandleScope::handleCount() != count)
+        fail("the slots of a scope were not released");
+}
+
+// The nodes of the handles span several chunks.
+static void __attribute__((noinline)) checkHandles()
+{
+    HandleScope scope;
+    Handle<Node>* handles = (Handle<Node>*)malloc(HANDLES * sizeof(Handle<Node>));
+    for (size_t i = 0; i < HANDLES; i++)
+        new (handles + i) Handle<Node>(newNode(i));
+    if (HandleScope::handleCount() != HANDLES)
+        fail("the handles were not counted");
+
+    GC_gcollect();
+    GC_gcollect();
+    for (size_t i = 0; i < HANDLES; i++) {
+        if (!isIntact(handles[i], i)) {
+            fail("an object kept by a handle was collected");
+            break;
+        }
+    }
+    free(handles);
+}
+
+static void __attribute__((noinline)) allocateNodes(Node* volatile* nodes, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        nodes[i] = newNode(i);
+}
+
+// The victims are only referenced from the stack of this frame.
+static void __attribute__((noinline)) checkStackNotScanned()
+{
+    Node* volatile victims[VICTIMS];
+    allocateNodes(victims, VICTIMS);
+    void** links = newLinks((Node**)victims, VICTIMS);
+
+    GC_gcollect();
+    if (countCleared(links, VICTIMS) < VICTIMS / 2)
+        fail("objects only referenced from the native stack were kept");
+}
+
+static void __attribute__((noinline)) callNative()
+{
+    Node* volatile kept[VICTIMS];
+    allocateNodes(kept, VICTIMS);
+    void** links = newLinks((Node**)kept, VICTIMS);
+
+    GC_gcollect();
+    if (countCleared(links, VICTIMS) != 0)
+        fail("objects referenced from the stack below a ConservativeStackScope were collected");
+    for (size_t i = 0; i < VICTIMS; i++) {
+        if (!isIntact(kept[i], i)) {
+            fail("an object referenced from the stack below a ConservativeStackScope was reused");
+            break;
+        }
+    }
+}
+
+static void __attribute__((noinline)) enterNative()
+{
+    ConservativeStackScope conservative;
+    callNative();
+}
+
+// The frame of this function is above the ConservativeStackScope.
+static void __attribute__((noinline)) checkHybrid()
+{
+    Node* volatile victims[VICTIMS];
+    allocateNodes(victims, VICTIMS);
+    void** links = newLinks((Node**)victims, VICTIMS);
+
+    enterNative();
+    GC_gcollect();
+    if (countCleared(links, VICTIMS) < VICTIMS / 2)
+        fail("objects above a ConservativeStackScope were kept");
+}
+
+int main()
+{
+    GC_INIT();
+    HandleScope::enablePreciseStackRoots();
+
+    HandleScope scope;
+    checkCopiedHandle();
+    checkHandles();
+    checkStackNotScanned();
+    checkHybrid();
+
+    HandleScope::disablePreciseStackRoots();
+    if (s_failures)
+        return 1;
+    printf("handle_scope_test: passed\n");
+    return 0;
+}
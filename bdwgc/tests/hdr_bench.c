@@ -0,0 +1,168 @@
+/*
+ * THIS MATERIAL IS PROVIDED AS IS, WITH ABSOLUTELY NO WARRANTY EXPRESSED
+ * OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission is hereby granted to use or copy this program
+ * for any purpose,  provided the above notices are retained on all copies.
+ * Permission to modify the code and to distribute modified code is granted,
+ * provided the above notices are retained, and a notice that the code was
+ * modified is included with the above copyright notice.
+ */
+
+/* Measure the block header lookups (through GC_base) per second for    */
+/* pointers to objects and for addresses between them (mostly misses),  */
+/* first in a dense heap, then in a sparse one made of small sections   */
+/* far apart.  The header index is a flat table with FLAT_TL (see       */
+/* gc_hdrs.h), otherwise a hash table on 64-bit targets, whose chains   */
+/* get longer in a sparse heap.                                         */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "gc.h"
+
+/* Include gc_priv.h is done after including GC public headers, so      */
+/* that GC_BUILD has no effect on the public prototypes.                */
+#include "private/gc_priv.h" /* for CLOCK_TYPE */
+
+#ifdef LINUX
+# include <sys/mman.h>
+#endif
+
+#ifdef NO_CLOCK
+  int main(void)
+  {
+    printf("hdr_bench: skipped (no clock)\n");
+    return 0;
+  }
+#else
+
+#define N_ADDRS 4096 /* a power of two */
+
+static GC_word next_random(GC_word *seed)
+{
+    /* xorshift; rand() is too slow and too narrow for the addresses.   */
+    GC_word x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *seed = x;
+}
+
+/* Return the lookups per second of GC_base on addrs, and the hits.     */
+static double measure(void **addrs, long lookups, long *hits)
+{
+    CLOCK_TYPE start, done;
+    unsigned long ms;
+    long i, found = 0;
+
+    GET_TIME(start);
+    for (i = 0; i < lookups; i++) {
+        if (GC_base(addrs[i & (N_ADDRS - 1)]) != NULL)
+            found++;
+    }
+    GET_TIME(done);
+    ms = MS_TIME_DIFF(done, start);
+    *hits = found;
+    return ms > 0 ? (double)lookups * 1000 / ms : 0.0;
+}
+
+/* Fill addrs with pointers into the objects and measure them, then    */
+/* with addresses in [lo, hi) at random.                                */
+static void measure_heap(const char *name, void **objs, long n,
+                         GC_word lo, GC_word hi, void **addrs, long lookups)
+{
+    GC_word seed = 2463534242UL;
+    long i, hits;
+    int mode;
+
+    for (mode = 0; mode < 2; mode++) {
+        double rate;
+
+        for (i = 0; i < N_ADDRS; i++) {
+            GC_word r = next_random(&seed);
+
+            addrs[i] = mode == 0
+                        ? (void *)((char *)objs[r % (GC_word)n] + (r >> 8) % 16)
+                        : (void *)(lo + r % (hi - lo));
+        }
+        rate = measure(addrs, lookups, &hits);
+        printf("%s heap, %s: %7.1f M lookups/s, %3ld%% hits\n", name,
+               mode == 0 ? "objects  " : "addresses", rate / 1e6,
+               (long)(hits * 100.0 / lookups));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long n = argc > 1 ? atol(argv[1]) : 1L << 18;
+    long lookups = argc > 2 ? atol(argv[2]) : 1L << 25;
+    void **objs;
+    void **addrs;
+    GC_word lo, hi;
+    long i;
+
+    GC_INIT();
+    if (n <= 0 || lookups <= 0) {
+        fprintf(stderr, "Usage: %s [objects [lookups]]\n", argv[0]);
+        return 1;
+    }
+    objs = (void **)GC_MALLOC(sizeof(void *) * n);
+    addrs = (void **)malloc(sizeof(void *) * N_ADDRS);
+    if (NULL == objs || NULL == addrs) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < n; i++) {
+        objs[i] = GC_MALLOC(16 << (i & 3));
+        if (NULL == objs[i]) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+    lo = (GC_word)GC_least_plausible_heap_addr;
+    hi = (GC_word)GC_greatest_plausible_heap_addr;
+    printf("Dense heap of %lu KiB\n", (unsigned long)(GC_get_heap_size() >> 10));
+    measure_heap("dense ", objs, n, lo, hi, addrs, lookups);
+
+#   if defined(LINUX) && CPP_WORDSZ == 64
+      {
+        /* Reserve a gap where the heap would grow next, so that each   */
+        /* new section is mapped 1 GiB away from the previous one.      */
+        long sects = 64, found = 0;
+
+        for (i = 0; i < sects; i++) {
+          void *hint = (char *)GC_greatest_plausible_heap_addr + HBLKSIZE;
+
+          (void)mmap(hint, (size_t)1 << 30, PROT_NONE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+          if (!GC_expand_hp(HBLKSIZE * 64)) break;
+        }
+        /* Keep only the objects allocated in the new sections.         */
+        for (i = 0; i < 8 * n && found < n; i++) {
+          void *p = GC_MALLOC(16 << (i & 3));
+
+          if (NULL == p) break;
+          if ((GC_word)p < lo || (GC_word)p >= hi) objs[found++] = p;
+        }
+        printf("Sparse heap of %lu KiB over %lu MiB\n",
+               (unsigned long)(GC_get_heap_size() >> 10),
+               (unsigned long)(((GC_word)GC_greatest_plausible_heap_addr
+                                - (GC_word)GC_least_plausible_heap_addr)
+                               >> 20));
+        if (found > 0)
+          measure_heap("sparse", objs, found,
+                       (GC_word)GC_least_plausible_heap_addr,
+                       (GC_word)GC_greatest_plausible_heap_addr,
+                       addrs, lookups);
+      }
+#   endif
+    return objs[0] != NULL ? 0 : 1;
+}
+
+#endif /* !NO_CLOCK */
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check GC_set_heap_reserve: the heap is committed in the reserved     */
+/* range, which does not move as the heap grows, and, with the          */
+/* "small" argument, grows out of the range once it is exhausted.  In   */
+/* both cases, the objects only referenced from the stack, which are    */
+/* found through the map of the heap sections, survive collections.     */
+
+#include <gc.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define RESERVE ((GC_word)256 << 20)
+#define SMALL_RESERVE ((GC_word)8 << 20)
+#define NODES 400000 /* About 25 MiB. */
+#define LARGE 64
+#define LARGE_SIZE (256 << 10)
+#define STACK_REFS 64
+
+struct Node {
+    Node* next;
+    size_t id;
+    size_t pad[6];
+};
+
+static int s_failures = 0;
+
+static void fail(const char* message)
+{
+    fprintf(stderr, "heap_reserve_test: %s\n", message);
+    s_failures++;
+}
+
+static bool inRange(void* p, char* start, GC_word size)
+{
+    return (GC_word)((char*)p - start) < size;
+}
+
+static Node* newNode(size_t id, Node* next)
+{
+    Node* node = (Node*)GC_MALLOC(sizeof(Node));
+    node->next = next;
+    node->id = id;
+    return node;
+}
+
+// The objects are only referenced from the stack of this frame (and
+// through the links, which are in malloc memory).
+static void __attribute__((noinline)) checkStackRefs(char* start, GC_word size, bool* outside)
+{
+    void* volatile refs[STACK_REFS];
+    void** links = (void**)malloc(STACK_REFS * sizeof(void*));
+    for (size_t i = 0; i < STACK_REFS; i++) {
+        refs[i] = i % 2 ? GC_MALLOC_ATOMIC(LARGE_SIZE) : newNode(i, nullptr);
+        links[i] = refs[i];
+        GC_GENERAL_REGISTER_DISAPPEARING_LINK(links + i, refs[i]);
+        if (!inRange(refs[i], start, size))
+            *outside = true;
+    }
+
+    GC_gcollect();
+    for (size_t i = 0; i < STACK_REFS; i++) {
+        if (!links[i]) {
+            fail("an object referenced from the stack was collected");
+            break;
+        }
+    }
+    for (size_t i = 0; i < STACK_REFS; i++)
+        GC_unregister_disappearing_link(links + i);
+    free(links);
+}
+
+int main(int argc, char** argv)
+{
+    bool small = argc > 1 && !strcmp(argv[1], "small");
+    GC_set_heap_reserve(small ? SMALL_RESERVE : RESERVE);
+    GC_INIT();
+
+    GC_word size;
+    char* start = (char*)GC_get_heap_reserve(&size);
+    if (!start) {
+        printf("heap_reserve_test: the heap reserve is not supported, skipped\n");
+        return 0;
+    }
+
+    void** roots = (void**)GC_MALLOC_UNCOLLECTABLE((LARGE + 1) * sizeof(void*));
+    Node* list = nullptr;
+    bool outside = false;
+    for (size_t i = 0; i < NODES; i++) {
+        list = newNode(i, list);
+        if (!inRange(list, start, size))
+            outside = true;
+    }
+    roots[0] = list;
+    for (size_t i = 0; i < LARGE; i++) {
+        roots[i + 1] = GC_MALLOC_ATOMIC(LARGE_SIZE);
+        memset(roots[i + 1], (int)i, LARGE_SIZE);
+        if (!inRange(roots[i + 1], start, size))
+            outside = true;
+    }
+    checkStackRefs(start, size, &outside);
+
+    GC_word newSize;
+    if (GC_get_heap_reserve(&newSize) != start || newSize != size)
+        fail("the reserved range moved");
+    if (small && !outside)
+        fail("the heap did not grow out of the exhausted range");
+    if (!small && outside)
+        fail("an object was allocated outside of the reserved range");
+
+    size_t id = NODES;
+    for (Node* node = (Node*)roots[0]; node; node = node->next) {
+        if (node->id != --id) {
+            fail("the list was corrupted");
+            break;
+        }
+    }
+    if (id != 0)
+        fail("the list was cut");
+    for (size_t i = 0; i < LARGE; i++) {
+        unsigned char* p = (unsigned char*)roots[i + 1];
+        if (p[0] != (unsigned char)i || p[LARGE_SIZE - 1] != (unsigned char)i) {
+            fail("a large object was corrupted");
+            break;
+        }
+    }
+
+    if (s_failures)
+        return 1;
+    printf("heap_reserve_test: passed (%lu KiB heap, %lu MiB reserved)\n",
+           (unsigned long)(GC_get_heap_size() >> 10), (unsigned long)(size >> 20));
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check GC_collect_until: a call whose deadline has passed does no     */
+/* collection work, short calls finish a collection over a large live   */
+/* tree between them while each one returns soon after its deadline,    */
+/* the finalizers of the garbage are invoked by the calls, and a call   */
+/* with nothing allocated since the last collection starts none.        */
+
+#include <gc.h>
+
+#include <cstdio>
+#include <ctime>
+
+#define DEPTH 18
+#define FINALIZABLE 1000
+#define SLICE_NS 1000000ULL
+#define MAX_OVERRUN_NS 20000000ULL
+#define MAX_CALLS 100000
+
+struct Node {
+    Node* left;
+    Node* right;
+    long value;
+};
+
+static int s_finalized = 0;
+
+static unsigned long long now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static Node* build(int depth)
+{
+    Node* node = (Node*)GC_MALLOC(sizeof(Node));
+    node->value = depth;
+    if (depth > 0) {
+        node->left = build(depth - 1);
+        node->right = build(depth - 1);
+    }
+    return node;
+}
+
+static long check(Node* node, int depth)
+{
+    if (node->value != depth)
+        return -1;
+    if (depth == 0)
+        return 1;
+    long left = check(node->left, depth - 1);
+    long right = check(node->right, depth - 1);
+    return left < 0 || right < 0 ? -1 : 1 + left + right;
+}
+
+static void countFinalized(void*, void*)
+{
+    s_finalized++;
+}
+
+static void __attribute__((noinline)) allocateFinalizable()
+{
+    for (int i = 0; i < FINALIZABLE; i++)
+        GC_REGISTER_FINALIZER(GC_MALLOC(sizeof(Node)), countFinalized, nullptr, nullptr, nullptr);
+}
+
+static int fail(const char* message)
+{
+    fprintf(stderr, "idle_test: %s\n", message);
+    return 1;
+}
+
+int main(void)
+{
+    GC_enable_incremental();
+    GC_INIT();
+    if (!GC_is_incremental_mode()) {
+        printf("idle_test: incremental mode is not supported, skipped\n");
+        return 0;
+    }
+    // Only GC_collect_until invokes the finalizers.
+    GC_set_finalize_on_demand(1);
+    // Mark the whole tree in each collection, not only the dirty pages.
+    GC_set_full_freq(0);
+
+    Node** roots = (Node**)GC_MALLOC_UNCOLLECTABLE(sizeof(Node*));
+    roots[0] = build(DEPTH);
+    // Finish the collections started by the allocation, and grow the
+    // mark stack, so the marking below is not restarted.
+    GC_gcollect();
+    GC_gcollect();
+    allocateFinalizable();
+
+    GC_word gcNo = GC_get_gc_no();
+    if (0 == GC_collect_until(0)) {
+        printf("idle_test: GC_collect_until is not supported, skipped\n");
+        return 0;
+    }
+    int result = GC_collect_until(now() - SLICE_NS);
+    if (result & (GC_IDLE_COLLECTED | GC_IDLE_MARK_DONE) || GC_get_gc_no() != gcNo
+        || s_finalized != 0)
+        return fail("a call past its deadline did collection work");
+
+    int calls = 0;
+    int collected = 0;
+    unsigned long long maxOverrun = 0;
+    do {
+        if (++calls > MAX_CALLS)
+            return fail("the collection did not finish");
+        unsigned long long deadline = now() + SLICE_NS;
+        result = GC_collect_until(deadline);
+        unsigned long long end = now();
+        if (end > deadline && end - deadline > maxOverrun)
+            maxOverrun = end - deadline;
+        collected |= result & GC_IDLE_COLLECTED;
+    } while (!collected || (result & GC_IDLE_ALL_DONE) != GC_IDLE_ALL_DONE);
+    printf("idle_test: %d calls, max overrun %llu us, %d finalized\n", calls, maxOverrun / 1000, s_finalized);
+
+    if (calls < 2)
+        return fail("the collection was not split between the calls");
+    if (maxOverrun > MAX_OVERRUN_NS)
+        return fail("a call returned too long after its deadline");
+    // Allow for a few objects still referenced from the stack.
+    if (s_finalized < FINALIZABLE - FINALIZABLE / 100)
+        return fail("the finalizers were not all invoked");
+    if (check(roots[0], DEPTH) != (2L << DEPTH) - 1)
+        return fail("the tree was corrupted");
+
+    gcNo = GC_get_gc_no();
+    result = GC_collect_until(now() + 1000 * SLICE_NS);
+    if (result != GC_IDLE_ALL_DONE || GC_get_gc_no() != gcNo)
+        return fail("a collection was started with nothing allocated");
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check that the trees of several isolates survive collections which   */
+/* are marked with helper threads (see GC_set_isolate_mark_threads),    */
+/* while the isolates collect concurrently and share the helper pool.   */
+
+#include "gc.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#define ISOLATES 3
+#define DEPTH 17 /* Above the heap size from which the helpers mark. */
+#define ROUNDS 8
+
+struct Node {
+    Node* left;
+    Node* right;
+    GC_word depth;
+};
+
+static Node* makeTree(GC_word depth)
+{
+    Node* node = (Node*)GC_MALLOC(sizeof(Node));
+    node->depth = depth;
+    if (depth > 0) {
+        node->left = makeTree(depth - 1);
+        node->right = makeTree(depth - 1);
+    }
+    return node;
+}
+
+static bool checkTree(Node* node, GC_word depth)
+{
+    if (node->depth != depth)
+        return false;
+    if (depth == 0)
+        return node->left == NULL && node->right == NULL;
+    return checkTree(node->left, depth - 1) && checkTree(node->right, depth - 1);
+}
+
+static void runIsolate(int id, bool* ok)
+{
+    GC_INIT();
+    GC_set_isolate_mark_threads(2);
+
+    Node* tree = makeTree(DEPTH);
+    for (int round = 0; round < ROUNDS; round++) {
+        // Garbage to be reclaimed around the live tree.
+        makeTree(DEPTH - 2);
+        GC_gcollect();
+        if (!checkTree(tree, DEPTH)) {
+            fprintf(stderr, "isolate_mark_test: isolate %d lost its tree in round %d\n", id, round);
+            *ok = false;
+            return;
+        }
+        // Replace a subtree, so that the next marking sees new objects.
+        tree->left = makeTree(DEPTH - 1);
+    }
+    *ok = true;
+}
+
+int main()
+{
+    bool ok[ISOLATES];
+    std::vector<std::thread> threads;
+    for (int i = 0; i < ISOLATES; i++)
+        threads.push_back(std::thread(runIsolate, i, &ok[i]));
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    for (int i = 0; i < ISOLATES; i++) {
+        if (!ok[i])
+            return 1;
+    }
+    printf("isolate_mark_test: passed\n");
+    return 0;
+}
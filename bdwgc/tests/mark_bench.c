@@ -0,0 +1,210 @@
+/*
+ * THIS MATERIAL IS PROVIDED AS IS, WITH ABSOLUTELY NO WARRANTY EXPRESSED
+ * OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission is hereby granted to use or copy this program
+ * for any purpose,  provided the above notices are retained on all copies.
+ * Permission to modify the code and to distribute modified code is granted,
+ * provided the above notices are retained, and a notice that the code was
+ * modified is included with the above copyright notice.
+ */
+
+/* Measure the mark throughput on a large graph of small objects        */
+/* pointing to each other at random (so nearly every pointer followed   */
+/* by the marker misses the cache), with and without the prefetching    */
+/* FIFO of the marker (see GC_set_mark_prefetch).  After each           */
+/* collection, every object reachable from the roots should be marked,  */
+/* so that an object missed by the marker makes it fail.                */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "gc.h"
+
+/* Include gc_priv.h is done after including GC public headers, so      */
+/* that GC_BUILD has no effect on the public prototypes.                */
+#include "private/gc_priv.h" /* for CLOCK_TYPE, GC_random, gc_mark.h */
+
+#ifdef LINT2
+# undef rand
+# define rand() (int)GC_random()
+#endif
+
+#ifdef NO_CLOCK
+  int main(void)
+  {
+    printf("mark_bench: skipped (no clock)\n");
+    return 0;
+  }
+#else
+
+#define N_LINKS 4
+
+struct node_s {
+    struct node_s *links[N_LINKS];
+    GC_word payload[2]; /* the index, and its complement as a check */
+};
+
+#define N_ROOTS 16
+
+#ifndef WARMUP_COLLECTIONS
+# define WARMUP_COLLECTIONS 10
+#endif
+
+static CLOCK_TYPE mark_start;
+static unsigned long mark_ms = 0;
+
+static void GC_CALLBACK on_event(GC_EventType event)
+{
+    CLOCK_TYPE now;
+
+    if (event == GC_EVENT_MARK_START) {
+        GET_TIME(mark_start);
+    } else if (event == GC_EVENT_MARK_END) {
+        GET_TIME(now);
+        mark_ms += MS_TIME_DIFF(now, mark_start);
+    }
+}
+
+/* Return an object holding the roots of the graph.     */
+static struct node_s **build_graph(long n)
+{
+    struct node_s **all = (struct node_s **)GC_MALLOC(sizeof(*all) * n);
+    struct node_s **roots = (struct node_s **)GC_MALLOC(sizeof(*roots)
+                                                        * N_ROOTS);
+    long i;
+    int j;
+
+    if (NULL == all || NULL == roots) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    for (i = 0; i < n; i++) {
+        all[i] = GC_NEW(struct node_s);
+        if (NULL == all[i]) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+        all[i] -> payload[0] = (GC_word)i;
+        all[i] -> payload[1] = ~(GC_word)i;
+    }
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < N_LINKS; j++) {
+            all[i] -> links[j] =
+                        all[((unsigned long)rand() << 15 ^ rand()) % n];
+        }
+    }
+    for (j = 0; j < N_ROOTS; j++)
+        roots[j] = all[j];
+    GC_FREE(all);
+    return roots;
+}
+
+/* Return the number of objects reachable from the roots, or -1 if one  */
+/* of them is broken or (if check_marks) not marked.                    */
+static long check_graph(struct node_s **roots, long n, int check_marks)
+{
+    unsigned char *seen = (unsigned char *)calloc(n, 1);
+    struct node_s **stack = (struct node_s **)malloc(sizeof(*stack) * n);
+    long top = 0, count = 0;
+    int j;
+
+    if (NULL == seen || NULL == stack) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    for (j = 0; j < N_ROOTS; j++) {
+        if (!seen[roots[j] -> payload[0]]) {
+            seen[roots[j] -> payload[0]] = 1;
+            stack[top++] = roots[j];
+        }
+    }
+    while (top > 0) {
+        struct node_s *p = stack[--top];
+
+        if (check_marks && !GC_is_marked(p)) {
+            count = -1;
+            break;
+        }
+        count++;
+        for (j = 0; j < N_LINKS; j++) {
+            struct node_s *q = p -> links[j];
+
+            if (NULL == q || q -> payload[0] >= (GC_word)n
+                || q -> payload[1] != ~(q -> payload[0])) {
+                count = -1;
+                goto done;
+            }
+            if (!seen[q -> payload[0]]) {
+                seen[q -> payload[0]] = 1;
+                stack[top++] = q;
+            }
+        }
+    }
+  done:
+    free(stack);
+    free(seen);
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    long n = argc > 1 ? atol(argv[1]) : 1L << 19;
+    int reps = argc > 2 ? atoi(argv[2]) : 4;
+    struct node_s **roots;
+    unsigned long ms[2] = { 0, 0 };
+    int i, mode;
+    double live_mb;
+    long reachable;
+
+    GC_INIT();
+    if (n <= N_ROOTS || reps <= 0) {
+        fprintf(stderr, "Usage: %s [objects [collections]]\n", argv[0]);
+        return 1;
+    }
+    roots = build_graph(n);
+    /* The mark stack overflows (and is enlarged) until it is deep      */
+    /* enough for the graph, which should not be measured.              */
+    for (i = 0; i < WARMUP_COLLECTIONS; i++)
+        GC_gcollect();
+    reachable = check_graph(roots, n, 0);
+    if (reachable < 0) {
+        fprintf(stderr, "mark_bench: the graph is broken\n");
+        return 1;
+    }
+    live_mb = (double)(GC_get_heap_size() - GC_get_free_bytes())
+                / (1024 * 1024);
+    GC_set_on_collection_event(on_event);
+    /* Alternate the modes to even out the noise.       */
+    for (i = 0; i < reps; i++) {
+        for (mode = 0; mode < 2; mode++) {
+#           ifdef ESCARGOT
+              GC_set_mark_prefetch(mode);
+#           endif
+            mark_ms = 0;
+            GC_gcollect();
+            ms[mode] += mark_ms;
+            if (check_graph(roots, n, 1) != reachable) {
+                fprintf(stderr, "mark_bench: a reachable object is not"
+                        " marked (prefetch %s)\n", mode ? "on" : "off");
+                return 1;
+            }
+        }
+    }
+    printf("%ld objects, %.1f MiB live\n", n, live_mb);
+    for (mode = 0; mode < 2; mode++) {
+        printf("prefetch %s: %6.1f ms per mark, %8.1f MiB/s\n",
+               mode ? "on " : "off", (double)ms[mode] / reps,
+               ms[mode] > 0 ? live_mb * reps * 1000 / ms[mode] : 0.0);
+    }
+#   ifndef ESCARGOT
+      printf("(the prefetch setting is not available)\n");
+#   endif
+    return 0;
+}
+
+#endif /* !NO_CLOCK */
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check that the slices of a paced incremental collection, including   */
+/* the sweep and the world-stop marking, stay within the pause target   */
+/* while short-lived objects are allocated over a large live tree.      */
+
+#include <gc.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#define PAUSE_TARGET_US 2000
+#define DEPTH 18
+#define WINDOW 1024
+#define ROUNDS 2000000
+
+struct Node {
+    Node* left;
+    Node* right;
+    long value;
+};
+
+static Node* build(int depth)
+{
+    Node* node = (Node*)GC_MALLOC(sizeof(Node));
+    node->value = depth;
+    if (depth > 0) {
+        node->left = build(depth - 1);
+        node->right = build(depth - 1);
+    }
+    return node;
+}
+
+static long check(Node* node, int depth)
+{
+    if (node->value != depth)
+        return -1;
+    if (depth == 0)
+        return 1;
+    long left = check(node->left, depth - 1);
+    long right = check(node->right, depth - 1);
+    return left < 0 || right < 0 ? -1 : 1 + left + right;
+}
+
+int main(void)
+{
+    GC_enable_incremental();
+    GC_INIT();
+    if (!GC_is_incremental_mode()) {
+        printf("pacer_test: incremental mode is not supported, skipped\n");
+        return 0;
+    }
+    GC_set_pause_target(PAUSE_TARGET_US, 0);
+
+    Node** roots = (Node**)GC_MALLOC_UNCOLLECTABLE(sizeof(Node*) * 2);
+    roots[0] = build(DEPTH);
+    Node** window = (Node**)GC_MALLOC(sizeof(Node*) * WINDOW);
+    roots[1] = (Node*)window;
+    for (long r = 0; r < ROUNDS; r++) {
+        Node* node = (Node*)GC_MALLOC(sizeof(Node));
+        node->value = r;
+        node->left = (r & 7) ? window[r % WINDOW] : nullptr;
+        window[r % WINDOW] = node;
+    }
+
+    if (check(roots[0], DEPTH) != (2L << DEPTH) - 1) {
+        fprintf(stderr, "pacer_test: the tree was corrupted\n");
+        return 1;
+    }
+
+    struct GC_pacer_stats stats;
+    GC_get_pacer_stats(&stats);
+    printf("pacer_test: %lu collections, %lu slices, %lu missed, %lu forced, max pause %lu us\n",
+           (unsigned long)GC_get_gc_no(), (unsigned long)stats.slices,
+           (unsigned long)stats.missed, (unsigned long)stats.forced,
+           (unsigned long)stats.max_pause_us);
+    if (stats.slices < 10) {
+        fprintf(stderr, "pacer_test: too few slices were paced\n");
+        return 1;
+    }
+    // Allow for a slice which is preempted now and then.
+    if (stats.missed * 20 > stats.slices) {
+        fprintf(stderr, "pacer_test: more than 5%% of the slices missed the target\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check the sweep of small object blocks (GC_reclaim_bits with        */
+/* BITMAP_SWEEP) for sizes whose objects do not start in every mark     */
+/* word (above 64 granules) as well as for small ones, with runs of     */
+/* live and dead objects: the live objects are kept intact, and the     */
+/* reclaimed ones are handed out again cleared (unless pointer-free)    */
+/* and without overlapping the live ones.                               */
+
+#include "gc.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define BLOCKS 6
+#define LIVE_BYTE 0xa5
+#define NEW_BYTE 0x3c
+
+static int s_failures = 0;
+
+static void fail(const char* message, size_t size, bool atomic, size_t index)
+{
+    fprintf(stderr, "sweep_test: %s (%zu bytes%s, object %zu)\n", message, size, atomic ? ", atomic" : "", index);
+    s_failures++;
+}
+
+static void* allocate(size_t size, bool atomic)
+{
+    return atomic ? GC_MALLOC_ATOMIC(size) : GC_MALLOC(size);
+}
+
+static bool isFilled(const unsigned char* p, size_t size, unsigned char value)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (p[i] != value)
+            return false;
+    }
+    return true;
+}
+
+// Mixes runs of live objects with runs of dead ones of various lengths.
+static bool isKept(size_t i)
+{
+    return i % 7 == 0 || i % 7 == 3 || i % 7 == 4;
+}
+
+static void __attribute__((noinline)) fill(void** objects, size_t count, size_t size, bool atomic)
+{
+    for (size_t i = 0; i < count; i++) {
+        objects[i] = allocate(size, atomic);
+        memset(objects[i], LIVE_BYTE, size);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!isKept(i))
+            objects[i] = NULL;
+    }
+}
+
+static void checkSize(size_t size, bool atomic)
+{
+    size_t count = BLOCKS * 4096 / size + 3;
+    void** objects = (void**)GC_MALLOC_UNCOLLECTABLE(count * sizeof(void*));
+
+    fill(objects, count, size, atomic);
+    GC_gcollect();
+
+    // Take (about) as many objects as were freed.
+    for (size_t i = 0; i < count; i++) {
+        if (isKept(i))
+            continue;
+        unsigned char* p = (unsigned char*)allocate(size, atomic);
+        if (!atomic && !isFilled(p, size, 0))
+            fail("reclaimed object is not cleared", size, atomic, i);
+        memset(p, NEW_BYTE, size);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (isKept(i) && !isFilled((unsigned char*)objects[i], size, LIVE_BYTE))
+            fail("live object was reclaimed", size, atomic, i);
+    }
+    GC_FREE(objects);
+}
+
+int main()
+{
+    // Sizes of 1 to 127 granules, those above 64 granules not starting
+    // an object in each mark word.
+    static const size_t sizes[] = { 16, 48, 80, 208, 528, 1008, 1040, 1104, 1360, 1632, 2032 };
+
+    GC_INIT();
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        checkSize(sizes[i], false);
+        checkSize(sizes[i], true);
+    }
+
+    if (s_failures)
+        return 1;
+    printf("sweep_test: passed\n");
+    return 0;
+}
@@ -747,6 +747,10 @@ void *GC_CALLBACK reverse_test_inner(void *data)
 #     define BIG 4500
 #   endif
 
+#   ifdef GC_DONT_REGISTER_MAIN_STATIC_DATA
+      /* A is the only static root of the test.  */
+      GC_add_roots((void *)&A, (void *)(&A + 1));
+#   endif
     a_set(ints(1, 49));
     b = ints(1, 50);
     c = ints(1, BIG);
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Grow, shrink and free Vector and SmallVector buffers, checking the   */
+/* elements, that the buffers keep their objects alive and that freed   */
+/* buffers do not overwrite other objects when reused.  With the        */
+/* "interior" argument, all interior pointers are recognized.           */
+
+#include "Vector.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace GCUtil;
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            fprintf(stderr, "vector_test:%d: %s failed\n", __LINE__, #cond); \
+            s_failures++;                                                     \
+        }                                                                     \
+    } while (0)
+
+// Not trivially copyable, so it is moved element by element.
+struct Tracked {
+    static int s_live;
+
+    Tracked(int value = 0)
+        : value(value)
+        , self(this)
+    {
+        s_live++;
+    }
+    Tracked(const Tracked& other)
+        : value(other.value)
+        , self(this)
+    {
+        s_live++;
+    }
+    Tracked(Tracked&& other)
+        : value(other.value)
+        , self(this)
+    {
+        s_live++;
+    }
+    Tracked& operator=(const Tracked& other)
+    {
+        value = other.value;
+        return *this;
+    }
+    ~Tracked()
+    {
+        s_live--;
+    }
+
+    int value;
+    Tracked* self;
+};
+
+int Tracked::s_live = 0;
+
+static void testGrowShrink()
+{
+    Vector<int> vector;
+    for (int i = 0; i < 10000; i++) {
+        vector.push_back(i);
+    }
+    CHECK(vector.size() == 10000);
+    CHECK(vector.capacity() >= 10000);
+    bool ok = true;
+    for (int i = 0; i < 10000; i++) {
+        ok &= vector[i] == i;
+    }
+    CHECK(ok);
+
+    vector.resize(10);
+    vector.shrink_to_fit();
+    CHECK(vector.size() == 10);
+    CHECK(vector.capacity() >= 10 && vector.capacity() < 100);
+    CHECK(vector[9] == 9);
+
+    vector.erase(vector.begin() + 2, vector.begin() + 5);
+    CHECK(vector.size() == 7 && vector[2] == 5);
+
+    vector.clear();
+    vector.shrink_to_fit();
+    CHECK(vector.empty());
+}
+
+static void testSmallVector()
+{
+    SmallVector<int, 4> vector;
+    int* inlineBuffer = vector.data();
+    for (int i = 0; i < 4; i++) {
+        vector.push_back(i);
+    }
+    CHECK(vector.data() == inlineBuffer);
+    vector.push_back(4);
+    CHECK(vector.data() != inlineBuffer);
+    vector.resize(3);
+    vector.shrink_to_fit();
+    CHECK(vector.data() == inlineBuffer);
+    CHECK(vector.size() == 3 && vector[2] == 2);
+
+    SmallVector<int, 4> moved(std::move(vector));
+    CHECK(moved.size() == 3 && moved[1] == 1);
+}
+
+static void testElementLifetimes()
+{
+    {
+        Vector<Tracked> vector;
+        for (int i = 0; i < 100; i++) {
+            vector.emplace_back(i);
+        }
+        bool ok = true;
+        for (int i = 0; i < 100; i++) {
+            ok &= vector[i].value == i && vector[i].self == &vector[i];
+        }
+        CHECK(ok);
+        CHECK(Tracked::s_live == 100);
+        vector.resize(20);
+        vector.shrink_to_fit();
+        CHECK(Tracked::s_live == 20);
+        CHECK(vector[19].self == &vector[19]);
+    }
+    CHECK(Tracked::s_live == 0);
+}
+
+struct Cell {
+    size_t id;
+    size_t check;
+};
+
+static void testBuffersKeepObjectsAlive()
+{
+    Vector<Cell*>* vector = new (GC_MALLOC_UNCOLLECTABLE(sizeof(Vector<Cell*>))) Vector<Cell*>();
+    for (size_t i = 0; i < 1000; i++) {
+        Cell* cell = (Cell*)GC_MALLOC(sizeof(Cell));
+        cell->id = i;
+        cell->check = ~i;
+        vector->push_back(cell);
+    }
+    GC_gcollect();
+    for (size_t i = 0; i < 1000; i++) {
+        Cell* garbage = (Cell*)GC_MALLOC(sizeof(Cell));
+        garbage->id = garbage->check = 0;
+    }
+    bool ok = true;
+    for (size_t i = 0; i < 1000; i++) {
+        ok &= (*vector)[i]->id == i && (*vector)[i]->check == ~i;
+    }
+    CHECK(ok);
+    vector->~Vector<Cell*>();
+    GC_FREE(vector);
+}
+
+// Buffers of several sizes are freed between objects which must keep
+// their contents when the freed buffers are reused.
+static void testFreedBuffersAreReusedSafely()
+{
+    const int count = 200;
+    char** guards = (char**)GC_MALLOC_UNCOLLECTABLE(sizeof(char*) * count);
+    for (int i = 0; i < count; i++) {
+        Vector<char> vector;
+        vector.resize(i % 120 + 1, 'x');
+        guards[i] = (char*)GC_MALLOC_ATOMIC(i % 120 + 1);
+        memset(guards[i], 'g', i % 120 + 1);
+    }
+    for (int i = 0; i < count; i++) {
+        size_t bytes = GC_size(guards[i]);
+        char* p = (char*)GC_MALLOC_ATOMIC(bytes);
+        memset(p, 'o', GC_size(p) - (GC_get_all_interior_pointers() ? 1 : 0));
+    }
+    bool ok = true;
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < i % 120 + 1; j++) {
+            ok &= guards[i][j] == 'g';
+        }
+    }
+    CHECK(ok);
+    GC_FREE(guards);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && !strcmp(argv[1], "interior")) {
+        GC_set_all_interior_pointers(1);
+    }
+    GC_INIT();
+
+    testGrowShrink();
+    testSmallVector();
+    testElementLifetimes();
+    testBuffersKeepObjectsAlive();
+    testFreedBuffersAreReusedSafely();
+
+    if (!s_failures)
+        printf("vector_test: passed\n");
+    return s_failures ? 1 : 0;
+}
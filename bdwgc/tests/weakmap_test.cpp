@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2015-present Samsung Electronics Co., Ltd
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ *  USA
+*/
+
+/* Check that the live entries of a weak map are still found after the  */
+/* dead ones are removed by a collection, with a hash which puts the    */
+/* keys in chosen slots so that clusters wrap around the end of the     */
+/* table.                                                               */
+
+#include "WeakMap.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace GCUtil;
+
+struct Key {
+    size_t home;
+};
+
+struct HomeHash {
+    size_t operator()(Key* key) const { return key->home; }
+};
+
+typedef WeakMap<Key*, size_t, HomeHash> Map;
+
+static Key* newKey(size_t home)
+{
+    Key* key = (Key*)GC_MALLOC_ATOMIC(sizeof(Key));
+    key->home = home;
+    return key;
+}
+
+static int s_failures = 0;
+
+static void check(Map& map, Key* key, size_t value, const char* name)
+{
+    size_t* found = map.find(key);
+    if (!found || *found != value) {
+        fprintf(stderr, "weakmap_test: %s was lost\n", name);
+        s_failures++;
+    }
+}
+
+// The keys which are only kept in this frame become unreachable when it
+// returns.
+static void __attribute__((noinline)) addWrappedCluster(Map& map, Key** live)
+{
+    // With 8 slots, the cluster wraps around: E(0)@0 F(6)@1 G(0)@2
+    // D(5)@5 B(5)@6 A(7)@7, where D and E die. The first slot which is
+    // empty after they are cleared (0) is in the middle of the cluster.
+    map.set(live[0] = newKey(7), 1);
+    map.set(newKey(5), 0);
+    map.set(live[1] = newKey(5), 2);
+    map.set(newKey(0), 0);
+    map.set(live[2] = newKey(6), 3);
+    map.set(live[3] = newKey(0), 4);
+}
+
+static void __attribute__((noinline)) addMany(Map& map, Key** live, size_t count, size_t slots)
+{
+    for (size_t i = 0; i < count; i++) {
+        Key* key = newKey((i * 7) % slots);
+        map.set(key, i);
+        if (i % 2) {
+            live[i / 2] = key;
+        }
+    }
+}
+
+static void __attribute__((noinline)) clobberStack()
+{
+    volatile char buffer[8192];
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = 0;
+    }
+}
+
+int main(void)
+{
+    GC_INIT();
+
+    Key** live = (Key**)GC_MALLOC_UNCOLLECTABLE(sizeof(Key*) * 512);
+    Map* map = new (GC_MALLOC_UNCOLLECTABLE(sizeof(Map))) Map();
+
+    addWrappedCluster(*map, live);
+    clobberStack();
+    GC_gcollect();
+    check(*map, live[0], 1, "A");
+    check(*map, live[1], 2, "B");
+    check(*map, live[2], 3, "F");
+    check(*map, live[3], 4, "G");
+    printf("weakmap_test: %u entries of the wrapped cluster left\n", (unsigned)map->size());
+
+    map->clear();
+    addMany(*map, live, 1000, 16);
+    clobberStack();
+    GC_gcollect();
+    for (size_t i = 0; i < 500; i++) {
+        check(*map, live[i], i * 2 + 1, "an entry");
+    }
+    printf("weakmap_test: %u of 1000 entries left\n", (unsigned)map->size());
+
+    return s_failures ? 1 : 0;
+}
@@ -340,6 +340,13 @@ STATIC mse * GC_typed_mark_proc(word * addr, mse * mark_stack_ptr,
 STATIC mse * GC_array_mark_proc(word * addr, mse * mark_stack_ptr,
                                 mse * mark_stack_limit, word env);
 
+#ifdef GC_COMPRESSED_POINTERS
+  STATIC MAY_THREAD_LOCAL int GC_compressed_mark_proc_index = 0;
+
+  STATIC mse * GC_compressed_mark_proc(word * addr, mse * mark_stack_ptr,
+                                       mse * mark_stack_limit, word env);
+#endif
+
 STATIC void GC_init_explicit_typing(void)
 {
     unsigned i;
@@ -362,6 +369,11 @@ STATIC void GC_init_explicit_typing(void)
       for (i = 1; i < WORDSZ/2; i++) {
           GC_bm_table[i] = (((word)-1) << (WORDSZ - i)) | GC_DS_BITMAP;
       }
+#   ifdef GC_COMPRESSED_POINTERS
+      GC_STATIC_ASSERT(sizeof(unsigned) == 4);
+      GC_compressed_mark_proc_index =
+                        GC_new_proc_inner(GC_compressed_mark_proc);
+#   endif
 }
 
 STATIC mse * GC_typed_mark_proc(word * addr, mse * mark_stack_ptr,
@@ -379,7 +391,7 @@ STATIC mse * GC_typed_mark_proc(word * addr, mse * mark_stack_ptr,
         if (bm & 1) {
             current = *current_p;
             FIXUP_POINTER(current);
-            if (current >= (word)least_ha && current <= (word)greatest_ha) {
+            if (current >= (word)least_ha && current < (word)greatest_ha) {
                 PUSH_CONTENTS((ptr_t)current, mark_stack_ptr,
                               mark_stack_limit, (ptr_t)current_p);
             }
@@ -401,6 +413,56 @@ STATIC mse * GC_typed_mark_proc(word * addr, mse * mark_stack_ptr,
     return(mark_stack_ptr);
 }
 
+#ifdef GC_COMPRESSED_POINTERS
+  /* The environment of GC_compressed_mark_proc is either the bitmap    */
+  /* of the slots shifted left by one and tagged with one (if it fits), */
+  /* or the index of an extended descriptor shifted left by one.        */
+# define COMPRESSED_INLINE_BITS \
+        (WORDSZ - GC_DS_TAG_BITS - GC_LOG_MAX_MARK_PROCS - 1)
+
+  STATIC mse * GC_compressed_mark_proc(word * addr, mse * mark_stack_ptr,
+                                       mse * mark_stack_limit, word env)
+  {
+    unsigned * current_p = (unsigned *)addr;
+    ptr_t base = GC_compressed_base;
+    ptr_t greatest_ha = (ptr_t)GC_greatest_plausible_heap_addr;
+    ptr_t least_ha = (ptr_t)GC_least_plausible_heap_addr;
+    GC_bool continued = FALSE;
+    word bm;
+    DECLARE_HDR_CACHE;
+
+    INIT_HDR_CACHE;
+    if ((env & 1) != 0) {
+        bm = env >> 1;
+    } else {
+        bm = GC_ext_descriptors[env >> 1].ed_bitmap;
+        continued = GC_ext_descriptors[env >> 1].ed_continued;
+    }
+    for (; bm != 0; bm >>= 1, current_p++) {
+        if ((bm & 1) != 0 && *current_p != 0) {
+            ptr_t current = base + *current_p;
+
+            if ((word)current >= (word)least_ha
+                && (word)current < (word)greatest_ha) {
+                PUSH_CONTENTS(current, mark_stack_ptr,
+                              mark_stack_limit, (ptr_t)current_p);
+            }
+        }
+    }
+    if (continued) {
+        /* As in GC_typed_mark_proc.    */
+        mark_stack_ptr++;
+        if ((word)mark_stack_ptr >= (word)mark_stack_limit) {
+            mark_stack_ptr = GC_signal_mark_stack_overflow(mark_stack_ptr);
+        }
+        mark_stack_ptr -> mse_start = (ptr_t)((unsigned *)addr + WORDSZ);
+        mark_stack_ptr -> mse_descr.w =
+                        GC_MAKE_PROC(GC_compressed_mark_proc_index, env + 2);
+    }
+    return(mark_stack_ptr);
+  }
+#endif /* GC_COMPRESSED_POINTERS */
+
 /* Return the size of the object described by d.  It would be faster to */
 /* store this directly, or to compute it as part of                     */
 /* GC_push_complex_descriptor, but hopefully it doesn't matter.         */
@@ -526,10 +588,8 @@ STATIC mse * GC_array_mark_proc(word * addr, mse * mark_stack_ptr,
     return new_mark_stack_ptr;
 }
 
-GC_API GC_descr GC_CALL GC_make_descriptor(const GC_word * bm, size_t len)
+STATIC void GC_init_explicit_typing_once(void)
 {
-    signed_word last_set_bit = len - 1;
-    GC_descr result;
     DCL_LOCK_STATE;
 
 #   if defined(AO_HAVE_load_acquire) && defined(AO_HAVE_store_release)
@@ -549,7 +609,14 @@ GC_API GC_descr GC_CALL GC_make_descriptor(const GC_word * bm, size_t len)
       }
       UNLOCK();
 #   endif
+}
+
+GC_API GC_descr GC_CALL GC_make_descriptor(const GC_word * bm, size_t len)
+{
+    signed_word last_set_bit = len - 1;
+    GC_descr result;
 
+    GC_init_explicit_typing_once();
     while (last_set_bit >= 0 && !GC_get_bit(bm, last_set_bit))
       last_set_bit--;
     if (last_set_bit < 0) return(0 /* no pointers */);
@@ -590,6 +657,37 @@ GC_API GC_descr GC_CALL GC_make_descriptor(const GC_word * bm, size_t len)
     return result;
 }
 
+#ifdef GC_COMPRESSED_POINTERS
+  GC_API GC_descr GC_CALL GC_make_compressed_descriptor(const GC_word * bm,
+                                                        size_t len)
+  {
+    signed_word last_set_bit = len - 1;
+    signed_word index;
+
+    GC_init_explicit_typing_once();
+    while (last_set_bit >= 0 && !GC_get_bit(bm, last_set_bit))
+      last_set_bit--;
+    if (last_set_bit < 0) return(0 /* no pointers */);
+
+    if ((word)last_set_bit < COMPRESSED_INLINE_BITS) {
+        word env = 0;
+        signed_word i;
+
+        for (i = last_set_bit; i >= 0; i--) {
+            env = (env << 1) | GC_get_bit(bm, i);
+        }
+        env = (env << 1) | 1;
+        return GC_MAKE_PROC(GC_compressed_mark_proc_index, env);
+    }
+    index = GC_add_ext_descriptor(bm, (word)last_set_bit + 1);
+    if (-1 == index)
+      ABORT("Insufficient memory for a compressed pointer descriptor");
+                                /* The slots cannot be scanned          */
+                                /* conservatively.                      */
+    return GC_MAKE_PROC(GC_compressed_mark_proc_index, (word)index << 1);
+  }
+#endif /* GC_COMPRESSED_POINTERS */
+
 GC_API GC_ATTR_MALLOC void * GC_CALL GC_malloc_explicitly_typed(size_t lb,
                                                                 GC_descr d)
 {